@@ -0,0 +1,52 @@
+#ifndef DTEKV_HAL_H
+#define DTEKV_HAL_H
+
+#include <stdint.h>
+
+/*
+ * Memory-mapped I/O access.
+ * On the board these are plain volatile pointers and stores. Building with
+ * -DDTEKV_HOST maps the I/O and VGA windows onto host arrays and counts
+ * every store, so render traffic can be measured without a board
+ * (see host/render-bench.c).
+ */
+
+#define DTEKV_IO_BASE   0x04000000
+#define DTEKV_IO_SIZE   0x200
+#define DTEKV_VGA_BASE  0x08000000
+#define DTEKV_VGA_SIZE  (320 * 240)
+
+#ifdef DTEKV_HOST
+
+typedef struct {
+    uint32_t stores;   /* store instructions */
+    uint32_t bytes;    /* bytes written by those stores */
+} HalStoreCount;
+
+typedef struct {
+    HalStoreCount fb;  /* VGA framebuffer */
+    HalStoreCount io;  /* peripheral registers */
+} HalStoreCounters;
+
+extern volatile uint32_t hal_io_space[DTEKV_IO_SIZE / 4];
+extern volatile uint8_t hal_vga_space[DTEKV_VGA_SIZE];
+extern HalStoreCounters hal_stores;
+extern uint32_t hal_cycles;   /* stands in for mcycle */
+
+#define IO_REG(addr)   (&hal_io_space[((addr) - DTEKV_IO_BASE) / 4])
+#define VGA_MEM(addr)  (&hal_vga_space[(addr) - DTEKV_VGA_BASE])
+
+#define IO_STORE(p, v) (hal_stores.io.stores++, hal_stores.io.bytes += sizeof(*(p)), *(p) = (v))
+#define FB_STORE(p, v) (hal_stores.fb.stores++, hal_stores.fb.bytes += sizeof(*(p)), *(p) = (v))
+
+#else
+
+#define IO_REG(addr)   ((volatile uint32_t *) (addr))
+#define VGA_MEM(addr)  ((volatile uint8_t *) (addr))
+
+#define IO_STORE(p, v) (*(p) = (v))
+#define FB_STORE(p, v) (*(p) = (v))
+
+#endif
+
+#endif
@@ -17,6 +17,49 @@ void printc(char s)
     *JTAG_UART = s;
 }
 
+/* Returns how many characters fit in the JTAG UART's TX FIFO right now (WSPACE). */
+int print_space(void)
+{
+  return (*JTAG_CTRL) >> 16;
+}
+
+/* Paced reports. printc() drops whatever does not fit in the 64-character
+   TX FIFO, so reports longer than that are split into pieces: report(n)
+   prints piece n and returns 0 once there are no more. print_report_poll()
+   sends pieces while the FIFO has room for a whole one, never waiting for
+   it, so it can be called from the main loop on every pass. */
+static print_piece_fn report_fn = 0;
+static int report_piece;
+
+/* Queues a report. Returns 0 if another one is still being sent. */
+int print_report_start(print_piece_fn report)
+{
+  if (report_fn)
+    return 0;
+  report_fn = report;
+  report_piece = 0;
+  return 1;
+}
+
+/* Returns nonzero while a report is still being sent. */
+int print_report_poll(void)
+{
+  while (report_fn && print_space() >= PRINT_PIECE_MAX) {
+    if (!report_fn(report_piece++))
+      report_fn = 0;
+  }
+  return report_fn != 0;
+}
+
+/* Returns the next character received on the JTAG UART, or -1 if none is waiting. */
+int readc(void)
+{
+  unsigned int data = *JTAG_UART;
+  if ((data & 0x8000) == 0)   /* RVALID */
+    return -1;
+  return data & 0xff;
+}
+
 void print(char *s)
 {  
   while (*s != '\0') {    
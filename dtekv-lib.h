@@ -1,5 +1,12 @@
 void printc(char );
 void print(char *);
+int readc(void);
+int print_space(void);
+/* Paced reports: piece n of a report is at most PRINT_PIECE_MAX characters */
+#define PRINT_PIECE_MAX 32
+typedef int (*print_piece_fn)(int n);
+int print_report_start(print_piece_fn report);
+int print_report_poll(void);
 void print_dec(unsigned int);
 void print_hex32 ( unsigned int);
 void handle_exception ( unsigned arg0, unsigned arg1, unsigned arg2, unsigned arg3, unsigned arg4, unsigned arg5, unsigned mcause, unsigned syscall_num );
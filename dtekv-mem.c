@@ -0,0 +1,81 @@
+#include "dtekv-mem.h"
+#include "dtekv-lib.h"
+
+#ifdef DTEKV_HOST
+/* No linker script on the host: report an empty map */
+static uint32_t host_stack[1];
+#define SECTION_SIZE(name) 0u
+#define STACK_BEGIN host_stack
+#define STACK_END host_stack
+#else
+extern uint32_t _text_begin[], _text_end[];
+extern uint32_t _data_begin[], _data_end[];
+extern uint32_t _bss_begin[], _bss_end[];
+extern uint32_t _rodata_begin[], _rodata_end[];
+extern uint32_t _stack_begin[], _stack_end[];
+#define SECTION_SIZE(name) ((uint32_t) ((char *) _##name##_end - (char *) _##name##_begin))
+#define STACK_BEGIN _stack_begin
+#define STACK_END _stack_end
+#endif
+
+/* The stack grows down from _stack_end, so the lowest word that no longer
+   holds the paint marks the peak. Scans up from the bottom, which is cheap
+   while most of the reservation is unused. */
+uint32_t mem_stack_peak(void)
+{
+  volatile uint32_t *p = STACK_BEGIN;
+  while (p < STACK_END && *p == STACK_PAINT)
+    p++;
+  return (uint32_t) ((char *) STACK_END - (char *) p);
+}
+
+void mem_usage(MemUsage *usage)
+{
+  usage->text = SECTION_SIZE(text);
+  usage->data = SECTION_SIZE(data);
+  usage->bss = SECTION_SIZE(bss);
+  usage->rodata = SECTION_SIZE(rodata);
+  usage->stack_size = (uint32_t) ((char *) STACK_END - (char *) STACK_BEGIN);
+  usage->stack_peak = mem_stack_peak();
+}
+
+/* Prints section sizes and the stack high-water mark over the JTAG UART,
+   one piece per call (see print_report_start). The figures are taken when
+   the first piece goes out. Returns 0 when done. */
+int mem_report(int piece)
+{
+  static MemUsage u;
+
+  switch (piece) {
+  case 0:
+    mem_usage(&u);
+    print("\n[mem] text=");
+    print_dec(u.text);
+    break;
+  case 1:
+    print(" data=");
+    print_dec(u.data);
+    print(" bss=");
+    print_dec(u.bss);
+    break;
+  case 2:
+    print(" rodata=");
+    print_dec(u.rodata);
+    printc('\n');
+    break;
+  case 3:
+    print("[mem] stack peak=");
+    print_dec(u.stack_peak);
+    break;
+  case 4:
+    print(" of ");
+    print_dec(u.stack_size);
+    print(" (");
+    print_dec(u.stack_size >= 100 ? u.stack_peak / (u.stack_size / 100) : 0);
+    print("%)\n");
+    break;
+  default:
+    return 0;
+  }
+  return 1;
+}
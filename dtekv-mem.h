@@ -0,0 +1,27 @@
+#ifndef DTEKV_MEM_H
+#define DTEKV_MEM_H
+
+#include <stdint.h>
+
+/*
+ * Memory usage report.
+ * Section sizes come from the _*_begin/_*_end symbols in dtekv-script.lds.
+ * boot.S paints the whole .stack with STACK_PAINT before main() runs, so
+ * the deepest the stack has ever been (trap frames included) is where the
+ * first overwritten word sits. The per-symbol breakdown is a build-time
+ * job: make mem-report (host/memreport.py).
+ */
+
+#define STACK_PAINT 0xA5A5A5A5u   /* Must match the paint loop in boot.S */
+
+typedef struct {
+  uint32_t text, data, bss, rodata;   /* Section sizes in bytes */
+  uint32_t stack_size;                /* Reserved stack (__stack_size) */
+  uint32_t stack_peak;                /* Deepest the stack has been */
+} MemUsage;
+
+uint32_t mem_stack_peak(void);
+void mem_usage(MemUsage *usage);
+int mem_report(int piece);
+
+#endif
@@ -0,0 +1,160 @@
+#include "dtekv-perf.h"
+#include "dtekv-lib.h"
+
+#ifdef DTEKV_HOST
+#define PERF_CSR(name, out) ((out) = 0)   /* no event counters off the board */
+#else
+#define PERF_CSR(name, out) asm volatile ("csrr %0, " #name : "=r"(out))
+#endif
+
+static const char *region_names[PERF_NUM_REGIONS] = { "render", "logic", "input" };
+
+/* Column headers for perf_report, matching the counter order */
+static const char *counter_names[PERF_NUM_COUNTERS] = {
+  "cycles", "instret", "memins", "icmiss", "dcmiss",
+  "istall", "dstall", "hazard", "alustall"
+};
+
+static uint32_t region_start[PERF_NUM_REGIONS][PERF_NUM_COUNTERS];
+static PerfTotals region_totals[PERF_NUM_REGIONS];
+static PerfTotals report_totals[PERF_NUM_REGIONS];   /* What perf_report() prints */
+
+/* Counts spent inside interrupt handlers so far, so that regions in the
+   main loop can leave out the handlers that interrupted them */
+static uint32_t irq_entry[PERF_NUM_COUNTERS];
+static uint32_t irq_totals[PERF_NUM_COUNTERS];
+static uint32_t region_irq_start[PERF_NUM_REGIONS][PERF_NUM_COUNTERS];
+
+/* Interrupts off and back on around main-loop code that touches totals the
+   handler's perf_end() calls add to. Returns the old mstatus.MIE. */
+static inline uint32_t irq_save(void)
+{
+#ifdef DTEKV_HOST
+  return 0;
+#else
+  uint32_t mstatus;
+  asm volatile ("csrrci %0, mstatus, 8" : "=r"(mstatus) :: "memory");
+  return mstatus & 8;
+#endif
+}
+
+static inline void irq_restore(uint32_t mie)
+{
+#ifndef DTEKV_HOST
+  asm volatile ("csrs mstatus, %0" :: "r"(mie) : "memory");
+#else
+  (void) mie;
+#endif
+}
+
+/* Snapshots every counter. The CSR number is part of the instruction,
+   so each one needs its own csrr. */
+void perf_read_all(uint32_t counts[PERF_NUM_COUNTERS])
+{
+#ifdef DTEKV_HOST
+  counts[0] = perf_read_cycles();
+#else
+  PERF_CSR(mcycle, counts[0]);
+#endif
+  PERF_CSR(minstret, counts[1]);
+  PERF_CSR(mhpmcounter3, counts[2]);   /* memory instructions */
+  PERF_CSR(mhpmcounter4, counts[3]);   /* I-cache misses */
+  PERF_CSR(mhpmcounter5, counts[4]);   /* D-cache misses */
+  PERF_CSR(mhpmcounter6, counts[5]);   /* I-cache stall cycles */
+  PERF_CSR(mhpmcounter7, counts[6]);   /* D-cache stall cycles */
+  PERF_CSR(mhpmcounter8, counts[7]);   /* data hazard stall cycles */
+  PERF_CSR(mhpmcounter9, counts[8]);   /* ALU stall cycles */
+}
+
+/* Brackets an interrupt handler, so that what it counts is not charged to a
+   main-loop region it interrupted. Regions inside the handler are
+   unaffected: irq_totals only moves on at perf_irq_exit(). */
+void perf_irq_enter(void)
+{
+  perf_read_all(irq_entry);
+}
+
+void perf_irq_exit(void)
+{
+  uint32_t now[PERF_NUM_COUNTERS];
+  perf_read_all(now);
+  for (int i = 0; i < PERF_NUM_COUNTERS; i++)
+    irq_totals[i] += now[i] - irq_entry[i];
+}
+
+/* The counters and irq_totals are sampled together with interrupts masked,
+   so a handler is either wholly inside the region's deltas or outside. */
+void perf_begin(PerfRegion region)
+{
+  uint32_t mie = irq_save();
+  perf_read_all(region_start[region]);
+  for (int i = 0; i < PERF_NUM_COUNTERS; i++)
+    region_irq_start[region][i] = irq_totals[i];
+  irq_restore(mie);
+}
+
+void perf_end(PerfRegion region)
+{
+  uint32_t now[PERF_NUM_COUNTERS];
+  uint32_t mie = irq_save();
+  perf_read_all(now);
+
+  PerfTotals *t = &region_totals[region];
+  t->calls++;
+  for (int i = 0; i < PERF_NUM_COUNTERS; i++)
+    t->counts[i] += (now[i] - region_start[region][i]) - (irq_totals[i] - region_irq_start[region][i]);
+  irq_restore(mie);
+}
+
+const PerfTotals *perf_totals(PerfRegion region)
+{
+  return &region_totals[region];
+}
+
+/* Hands the totals so far to perf_report() and starts new ones. Interrupts
+   are masked meanwhile, so a handler's perf_end() cannot land half way. */
+void perf_reset(void)
+{
+  uint32_t mie = irq_save();
+  for (int r = 0; r < PERF_NUM_REGIONS; r++) {
+    report_totals[r] = region_totals[r];
+    region_totals[r].calls = 0;
+    for (int i = 0; i < PERF_NUM_COUNTERS; i++)
+      region_totals[r].counts[i] = 0;
+  }
+  irq_restore(mie);
+}
+
+/* Prints the totals taken by the last perf_reset(), one piece per call (see
+   print_report_start): a header line, then one line per region with its
+   name, number of calls and each counter total. Returns 0 when done. */
+int perf_report(int piece)
+{
+  int row = piece / (PERF_NUM_COUNTERS + 1);
+  int col = piece % (PERF_NUM_COUNTERS + 1);
+  if (row > PERF_NUM_REGIONS)
+    return 0;
+
+  if (row == 0) {
+    if (col == 0) {
+      print("\n[perf] region calls");
+    } else {
+      printc(' ');
+      print((char *) counter_names[col - 1]);
+    }
+  } else {
+    const PerfTotals *t = &report_totals[row - 1];
+    if (col == 0) {
+      print("[perf] ");
+      print((char *) region_names[row - 1]);
+      printc(' ');
+      print_dec(t->calls);
+    } else {
+      printc(' ');
+      print_dec(t->counts[col - 1]);
+    }
+  }
+  if (col == PERF_NUM_COUNTERS)
+    printc('\n');
+  return 1;
+}
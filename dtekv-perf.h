@@ -0,0 +1,52 @@
+#ifndef DTEKV_PERF_H
+#define DTEKV_PERF_H
+
+#include <stdint.h>
+#include "dtekv-hal.h"
+
+/*
+ * Scoped profiling regions on top of the DTEK-V hardware counters.
+ * Wrap a piece of work in perf_begin()/perf_end() with the same region and
+ * the counter deltas are accumulated for that region until perf_reset(),
+ * which hands them to perf_report().
+ * Regions must not nest with themselves. Interrupt handlers bracketed with
+ * perf_irq_enter()/perf_irq_exit() are left out of regions they interrupt.
+ */
+
+typedef enum {
+    PERF_RENDER,   /* clear_screen, draw_* */
+    PERF_LOGIC,    /* update_game and friends */
+    PERF_INPUT,    /* switch and button handling */
+    PERF_NUM_REGIONS
+} PerfRegion;
+
+/* mcycle, minstret and mhpmcounter3..9, in that order */
+#define PERF_NUM_COUNTERS 9
+
+typedef struct {
+    uint32_t calls;
+    uint32_t counts[PERF_NUM_COUNTERS];
+} PerfTotals;
+
+/* Low 32 bits of the cycle counter (wraps every ~143 s at 30 MHz). */
+static inline uint32_t perf_read_cycles(void)
+{
+#ifdef DTEKV_HOST
+    return hal_cycles;   /* advanced by the host harness */
+#else
+    uint32_t cycles;
+    asm volatile ("csrr %0, mcycle" : "=r"(cycles));
+    return cycles;
+#endif
+}
+
+void perf_read_all(uint32_t counts[PERF_NUM_COUNTERS]);
+void perf_irq_enter(void);
+void perf_irq_exit(void);
+void perf_begin(PerfRegion region);
+void perf_end(PerfRegion region);
+const PerfTotals *perf_totals(PerfRegion region);
+void perf_reset(void);
+int perf_report(int piece);
+
+#endif
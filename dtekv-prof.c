@@ -0,0 +1,94 @@
+#include "dtekv-prof.h"
+#include "dtekv-lib.h"
+
+/* Longest bucket line: "0x0000FFF0 65535\n" */
+#define PROF_LINE_MAX 20
+
+static uint16_t buckets[PROF_BUCKETS];
+static uint32_t samples = 0;
+static uint32_t outside = 0;   /* PCs past PROF_TEXT_SIZE */
+
+/* Dump state: -2 idle, -1 header pending, else next bucket to send */
+static volatile int dump_pos = -2;
+
+static inline uint32_t read_mepc(void)
+{
+#ifdef DTEKV_HOST
+  return 0;
+#else
+  uint32_t pc;
+  asm volatile ("csrr %0, mepc" : "=r"(pc));
+  return pc;
+#endif
+}
+
+/* Scheduler task: called from the timer interrupt, so mepc is the
+   address of the interrupted instruction. */
+void prof_task(void)
+{
+  if (dump_pos != -2)
+    return;   /* Hold still while the histogram is streamed out */
+
+  uint32_t pc = read_mepc();
+  samples++;
+  if (pc >= PROF_TEXT_SIZE) {
+    outside++;
+    return;
+  }
+  uint16_t *b = &buckets[pc >> PROF_BUCKET_SHIFT];
+  if (*b != 0xFFFF)   /* Saturate rather than wrap */
+    (*b)++;
+}
+
+void prof_reset(void)
+{
+  for (int i = 0; i < PROF_BUCKETS; i++)
+    buckets[i] = 0;
+  samples = 0;
+  outside = 0;
+}
+
+/* Starts streaming the histogram out; prof_dump_poll() does the work. */
+void prof_dump_start(void)
+{
+  if (dump_pos == -2)
+    dump_pos = -1;
+}
+
+/* Sends as much of the dump as fits in the UART's TX FIFO without waiting,
+   so it can be called from the main loop on every pass. The histogram is
+   cleared once the whole dump has gone out. */
+void prof_dump_poll(void)
+{
+  if (dump_pos == -2)
+    return;
+
+  if (dump_pos == -1) {
+    if (print_space() < 64)
+      return;
+    print("\n[prof] begin shift=");
+    print_dec(PROF_BUCKET_SHIFT);
+    print(" samples=");
+    print_dec(samples);
+    print(" outside=");
+    print_dec(outside);
+    printc('\n');
+    dump_pos = 0;
+  }
+
+  while (dump_pos < PROF_BUCKETS && print_space() >= PROF_LINE_MAX) {
+    if (buckets[dump_pos] != 0) {
+      print_hex32(dump_pos << PROF_BUCKET_SHIFT);
+      printc(' ');
+      print_dec(buckets[dump_pos]);
+      printc('\n');
+    }
+    dump_pos++;
+  }
+
+  if (dump_pos == PROF_BUCKETS && print_space() >= PROF_LINE_MAX) {
+    print("[prof] end\n");
+    prof_reset();
+    dump_pos = -2;
+  }
+}
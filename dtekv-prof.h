@@ -0,0 +1,30 @@
+#ifndef DTEKV_PROF_H
+#define DTEKV_PROF_H
+
+#include <stdint.h>
+#include "dtekv-sched.h"
+
+/*
+ * Statistical PC-sampling profiler, built in with make PROFILE=1 (-DPROFILE_PC).
+ * A scheduler task records mepc - where the timer interrupt found the CPU -
+ * into a histogram with one counter per PROF_BUCKET_BYTES of .text. Sending
+ * 'f' on the JTAG UART streams the non-empty buckets out, and
+ * host/pcprof.py turns them into a flat per-function profile with the
+ * symbols from main.elf.txt. Interrupts are off while the handler runs, so
+ * the handler itself never shows up; its cost is what dtekv-perf measures.
+ */
+
+#define PROF_BUCKET_SHIFT 4                          /* 16 bytes = 4 instructions */
+#define PROF_BUCKET_BYTES (1 << PROF_BUCKET_SHIFT)
+#define PROF_TEXT_SIZE    0x10000                    /* .text starts at 0 (dtekv-script.lds) */
+#define PROF_BUCKETS      (PROF_TEXT_SIZE >> PROF_BUCKET_SHIFT)
+
+/* Just under 1 kHz, so sampling does not lock step with the 30 Hz UI task */
+#define PROF_INTERVAL     (SCHED_CPU_HZ / 997)
+
+void prof_task(void);
+void prof_reset(void);
+void prof_dump_start(void);
+void prof_dump_poll(void);
+
+#endif
@@ -0,0 +1,126 @@
+#include "dtekv-sched.h"
+#include "dtekv-hal.h"
+#include "dtekv-perf.h"
+
+#define TIMER_CONTROL  IO_REG(0x4000024)
+#define TIMER_PERIOD_L IO_REG(0x4000028)
+#define TIMER_PERIOD_H IO_REG(0x400002C)
+
+#define TIMER_ITO   0x1   /* interrupt on timeout */
+#define TIMER_START 0x4
+#define TIMER_STOP  0x8
+
+/* Shortest one-shot we program, so an overdue task still gets a clean interrupt */
+#define SCHED_MIN_DELTA 64
+/* Timeout used when no task is enabled */
+#define SCHED_IDLE_PERIOD SCHED_CPU_HZ
+
+typedef struct {
+    SchedFn run;
+    uint32_t period;     /* cycles between runs */
+    uint32_t deadline;   /* mcycle value of the next run */
+    uint8_t enabled;
+} SchedTask;
+
+static SchedTask tasks[SCHED_MAX_TASKS];
+static int num_tasks = 0;
+static uint32_t next_deadline = 0;
+static uint32_t missed_runs = 0;
+
+/* Signed distance, so comparisons survive mcycle wrapping */
+static inline int32_t cycles_until(uint32_t deadline, uint32_t now)
+{
+  return (int32_t) (deadline - now);
+}
+
+static void program_timer(uint32_t delta)
+{
+  /* Writing the period stops the counter and reloads it; no CONT bit = one-shot */
+  IO_STORE(TIMER_CONTROL, TIMER_STOP);
+  IO_STORE(TIMER_PERIOD_L, (delta - 1) & 0xFFFF);
+  IO_STORE(TIMER_PERIOD_H, (delta - 1) >> 16);
+  IO_STORE(TIMER_CONTROL, TIMER_ITO | TIMER_START);
+}
+
+/* Registers a task, initially disabled. Returns its id, or -1 if the table is full. */
+int sched_add(SchedFn run, uint32_t period)
+{
+  if (num_tasks == SCHED_MAX_TASKS)
+    return -1;
+  tasks[num_tasks].run = run;
+  tasks[num_tasks].period = period;
+  tasks[num_tasks].enabled = 0;
+  return num_tasks++;
+}
+
+/* Enabling (re)starts the task one full period from now. */
+void sched_enable(int task, int enabled)
+{
+  if (enabled && !tasks[task].enabled)
+    tasks[task].deadline = perf_read_cycles() + tasks[task].period;
+  tasks[task].enabled = enabled;
+}
+
+/* Takes effect from the next run; the pending deadline is kept. */
+void sched_set_period(int task, uint32_t period)
+{
+  tasks[task].period = period;
+}
+
+/*
+ * Called from the timer interrupt: runs every task that is due. A task that
+ * fell more than a whole period behind skips the runs it missed rather than
+ * running back to back; those are counted in sched_missed_runs().
+ */
+void sched_dispatch(void)
+{
+  uint32_t now = perf_read_cycles();
+
+  for (int i = 0; i < num_tasks; i++) {
+    SchedTask *t = &tasks[i];
+    if (!t->enabled || cycles_until(t->deadline, now) > 0)
+      continue;
+
+    t->run();
+
+    if (t->enabled) {
+      t->deadline += t->period;
+      if (cycles_until(t->deadline, now) <= 0) {
+        uint32_t behind = (now - t->deadline) / t->period + 1;
+        t->deadline += behind * t->period;
+        missed_runs += behind;
+      }
+    }
+  }
+}
+
+/*
+ * Programs the timer as a one-shot for the earliest enabled deadline.
+ * Call after sched_dispatch() and after any task set changes, at the end of
+ * the interrupt. Returns the slack in cycles before that deadline; zero or
+ * negative means the work overran into it.
+ */
+int32_t sched_arm(void)
+{
+  uint32_t now = perf_read_cycles();
+
+  next_deadline = now + SCHED_IDLE_PERIOD;
+  for (int i = 0; i < num_tasks; i++)
+    if (tasks[i].enabled && cycles_until(tasks[i].deadline, next_deadline) < 0)
+      next_deadline = tasks[i].deadline;
+
+  int32_t slack = cycles_until(next_deadline, now);
+  program_timer(slack > SCHED_MIN_DELTA ? (uint32_t) slack : SCHED_MIN_DELTA);
+  return slack;
+}
+
+/* mcycle value the timer is currently armed for */
+uint32_t sched_next_deadline(void)
+{
+  return next_deadline;
+}
+
+uint32_t sched_missed_runs(void)
+{
+  return missed_runs;
+}
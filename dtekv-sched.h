@@ -0,0 +1,29 @@
+#ifndef DTEKV_SCHED_H
+#define DTEKV_SCHED_H
+
+#include <stdint.h>
+
+/*
+ * Tickless deadline scheduler.
+ * Periodic tasks run from the timer interrupt at their own rates. Instead of
+ * a fixed tick, the timer is reprogrammed as a one-shot for whichever task is
+ * due next, so there are no interrupts that find nothing to do. Time is the
+ * mcycle counter; the interval timer runs off the same 30 MHz clock.
+ */
+
+#define SCHED_CPU_HZ 30000000
+#define SCHED_MS(ms) ((uint32_t) (ms) * (SCHED_CPU_HZ / 1000))
+
+#define SCHED_MAX_TASKS 8
+
+typedef void (*SchedFn)(void);
+
+int sched_add(SchedFn run, uint32_t period);
+void sched_enable(int task, int enabled);
+void sched_set_period(int task, uint32_t period);
+void sched_dispatch(void);
+int32_t sched_arm(void);
+uint32_t sched_next_deadline(void);
+uint32_t sched_missed_runs(void);
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef DTEKV_SEQLOCK_H
+#define DTEKV_SEQLOCK_H
+
+#include <stdint.h>
+
+/*
+ * Sequence lock over two alternating snapshot slots.
+ * One writer (the interrupt handler) publishes a new snapshot by filling the
+ * slot readers are not using and then bumping the sequence counter; readers
+ * (the main loop) copy out the slot the counter points at and retry if the
+ * writer came round to that slot again while they were copying. Neither side
+ * ever blocks or has to mask interrupts.
+ *
+ * seq is odd while a write is in progress; seq >> 1 counts finished writes,
+ * and the latest snapshot is in slot (seq >> 1) & 1.
+ */
+
+typedef struct {
+    volatile uint32_t seq;
+} SeqLock;
+
+// Word type allowed to alias the snapshot structs it copies
+typedef uint32_t __attribute__((may_alias)) seqlock_word;
+
+// Keeps the compiler from moving snapshot accesses across the counter updates
+#define SEQLOCK_BARRIER() asm volatile ("" ::: "memory")
+
+/*
+ * Starts a write. Returns the slot to fill: the one readers are not reading.
+ */
+static inline int seqlock_write_begin(SeqLock *lock) {
+    uint32_t seq = lock->seq + 1;
+    lock->seq = seq;
+    SEQLOCK_BARRIER();
+    return ((seq >> 1) + 1) & 1;
+}
+
+/*
+ * Finishes a write, making the slot from seqlock_write_begin() the latest.
+ */
+static inline void seqlock_write_end(SeqLock *lock) {
+    SEQLOCK_BARRIER();
+    lock->seq = lock->seq + 1;
+}
+
+/*
+ * Starts a read. Returns the sequence value to hand to the other read calls.
+ */
+static inline uint32_t seqlock_read_begin(const SeqLock *lock) {
+    uint32_t seq = lock->seq;
+    SEQLOCK_BARRIER();
+    return seq;
+}
+
+/*
+ * Slot holding the latest finished snapshot as of seq. A write in progress
+ * (odd seq) is filling the other slot, so this one is still whole.
+ */
+static inline int seqlock_read_slot(uint32_t seq) {
+    return (seq >> 1) & 1;
+}
+
+/*
+ * Returns nonzero if the slot read since seqlock_read_begin() may be torn.
+ * The slot is only reused two writes after it was published, so one write
+ * finishing in between (seq moving on by 2) is harmless.
+ */
+static inline int seqlock_read_retry(const SeqLock *lock, uint32_t seq) {
+    SEQLOCK_BARRIER();
+    return lock->seq - (seq & ~1u) > 2;
+}
+
+/*
+ * Copies a snapshot word by word. The volatile destination stops the compiler
+ * from turning the loop into a memcpy() call, which the bare-metal build has
+ * no library for. Sizes must be a whole number of words.
+ */
+static inline void seqlock_copy(void *dst, const void *src, uint32_t bytes) {
+    volatile seqlock_word *d = (volatile seqlock_word *) dst;
+    const seqlock_word *s = (const seqlock_word *) src;
+    for (uint32_t i = 0; i < bytes / 4; i++) {
+        d[i] = s[i];
+    }
+}
+
+#endif
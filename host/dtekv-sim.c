@@ -0,0 +1,949 @@
+/*
+ * DTEK-V instruction-set simulator.
+ *
+ * Runs the main.elf the Makefile builds, the exact binary that goes on the
+ * board, on an RV32IM + Zicsr interpreter with the DTEK-V memory map:
+ * interval timer, switches (with edge capture and interrupt mask), buttons,
+ * LEDs, 7-segment displays, JTAG UART and the VGA framebuffer. Interrupts
+ * follow the machine-mode flow boot.S relies on (mtvec, mcause, mepc, mret,
+ * mstatus.MIE/MPIE). Time is counted in cycles with a configurable cost per
+ * instruction class, and the interval timer counts down at the same 30 MHz,
+ * so timing-dependent code behaves as it does on the board (approximately:
+ * there is no cache or pipeline model). The JTAG UART's 64-character TX
+ * FIFO drains to the host at a configurable rate; writes to a full FIFO are
+ * dropped, as on the board.
+ *
+ * Inputs come from a script, one event per line, "<time> <command> [arg]":
+ *
+ *   # time is cycles, or with an ms / s suffix
+ *   500ms  btn  1          buttons (BTN0 = bit 0)
+ *   520ms  btn  0
+ *   1s     sw   0x2        switches; changed bits latch in edge capture
+ *   3s     uart w          characters for the JTAG UART (\n for newline)
+ *   4s     dump frame.ppm  write the framebuffer as a PPM image
+ *   5s     report          print the statistics so far
+ *   6s     quit
+ *
+ * At the end it reports cycles, instructions and cycles per interrupt
+ * handler invocation (trap entry to mret) for each interrupt cause.
+ *
+ *   dtekv-sim [-s script] [-t time] [-q] [--cost class=n,...] [--uart-rate n] [--ppm file] main.elf
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../dtekv-hal.h"
+
+#define CPU_HZ      30000000
+#define RAM_SIZE    (32u << 20)       /* dtekv-script.lds: RAM at 0, 32M */
+#define VGA_WIDTH   320
+#define VGA_HEIGHT  240
+
+/* Peripheral register offsets in the I/O window */
+#define IO_LEDS         0x00
+#define IO_SW_DATA      0x10
+#define IO_SW_MASK      0x18
+#define IO_SW_EDGE      0x1C
+#define IO_TIMER_STATUS 0x20
+#define IO_TIMER_CTRL   0x24
+#define IO_TIMER_PERL   0x28
+#define IO_TIMER_PERH   0x2C
+#define IO_UART_DATA    0x40
+#define IO_UART_CTRL    0x44
+#define IO_SEG_BASE     0x50          /* display n at 0x50 + 16 * n */
+#define IO_SEG_COUNT    6
+#define IO_BTN_DATA     0xD0
+
+#define TIMER_TO    0x1               /* status: timed out */
+#define TIMER_RUN   0x2               /* status: counting */
+#define TIMER_ITO   0x1               /* control: interrupt on timeout */
+#define TIMER_CONT  0x2
+#define TIMER_START 0x4
+#define TIMER_STOP  0x8
+
+#define IRQ_TIMER   16
+#define IRQ_SWITCH  17
+#define NUM_CAUSES  32
+
+#define UART_FIFO   64
+#define UART_RATE   10000             /* default TX drain, characters per second */
+
+#define MSTATUS_MIE  0x8
+#define MSTATUS_MPIE 0x80
+
+// --- Cost model ---------------------------------------------------------
+
+typedef struct {
+    const char *name;
+    unsigned cycles;
+    const char *help;
+} Cost;
+
+enum { C_ALU, C_LOAD, C_STORE, C_MUL, C_DIV, C_BRANCH, C_TAKEN, C_JUMP, C_CSR, C_IO, C_TRAP, NUM_COSTS };
+
+static Cost costs[NUM_COSTS] = {
+    [C_ALU]    = {"alu",    1,  "register and immediate arithmetic, lui, auipc"},
+    [C_LOAD]   = {"load",   2,  "loads"},
+    [C_STORE]  = {"store",  1,  "stores"},
+    [C_MUL]    = {"mul",    3,  "mul, mulh*"},
+    [C_DIV]    = {"div",    34, "div*, rem*"},
+    [C_BRANCH] = {"branch", 1,  "conditional branches"},
+    [C_TAKEN]  = {"taken",  2,  "extra for a taken branch"},
+    [C_JUMP]   = {"jump",   3,  "jal, jalr"},
+    [C_CSR]    = {"csr",    1,  "csr*, mret, ecall, fence, wfi"},
+    [C_IO]     = {"io",     4,  "extra for a peripheral or framebuffer access"},
+    [C_TRAP]   = {"trap",   4,  "taking an interrupt or exception"},
+};
+
+// --- Machine state --------------------------------------------------------
+
+typedef struct {
+    uint32_t x[32];
+    uint32_t pc;
+    uint64_t cycles;
+    uint64_t instret;
+    uint64_t mem_ops;          /* mhpmcounter3: memory instructions */
+    uint32_t mstatus, mie, mtvec, mscratch, mepc, mcause, mtval;
+} Cpu;
+
+typedef struct {
+    uint32_t leds;
+    uint32_t switches, sw_mask, sw_edge;
+    uint32_t buttons;
+    uint32_t seg[IO_SEG_COUNT];
+    uint32_t timer_status, timer_ctrl, timer_period;
+    uint64_t timer_count;      /* cycles left until timeout while running */
+    char uart_in[256];
+    int uart_in_head, uart_in_len;
+    int uart_tx_fill;          /* characters waiting in the TX FIFO */
+    uint64_t uart_tx_credit;   /* drain progress, in characters * CPU_HZ */
+    uint64_t uart_out, uart_dropped;
+} Io;
+
+typedef struct {
+    uint64_t count, total, min, max;
+    uint64_t log2_hist[40];
+} IsrStats;
+
+static uint8_t *ram;
+static uint8_t vga[DTEKV_VGA_SIZE];
+static Cpu cpu;
+static Io io;
+static IsrStats isr_stats[NUM_CAUSES];
+static IsrStats exc_stats;
+static int quiet = 0;
+static unsigned uart_rate = UART_RATE;   /* 0: the TX FIFO never backs up */
+
+// Open trap, for the handler statistics
+static int in_trap = 0;
+static uint32_t trap_cause;
+static uint64_t trap_start;
+
+static void fatal(const char *what, uint32_t value) {
+    fprintf(stderr, "dtekv-sim: %s 0x%08X (pc 0x%08X, cycle %llu)\n",
+            what, value, cpu.pc, (unsigned long long) cpu.cycles);
+    exit(1);
+}
+
+// --- Peripherals --------------------------------------------------------
+
+static void timer_load(void) {
+    io.timer_count = (uint64_t) io.timer_period + 1;
+}
+
+static uint32_t io_read(uint32_t off) {
+    switch (off) {
+    case IO_LEDS:         return io.leds;
+    case IO_SW_DATA:      return io.switches;
+    case IO_SW_MASK:      return io.sw_mask;
+    case IO_SW_EDGE:      return io.sw_edge;
+    case IO_BTN_DATA:     return io.buttons;
+    case IO_TIMER_STATUS: return io.timer_status;
+    case IO_TIMER_CTRL:   return io.timer_ctrl;
+    case IO_TIMER_PERL:   return io.timer_period & 0xFFFF;
+    case IO_TIMER_PERH:   return io.timer_period >> 16;
+    case IO_UART_CTRL:    return (uint32_t) (UART_FIFO - io.uart_tx_fill) << 16;   /* WSPACE */
+    case IO_UART_DATA:
+        if (io.uart_in_len == 0) {
+            return 0;
+        } else {
+            uint32_t c = (uint8_t) io.uart_in[io.uart_in_head];
+            io.uart_in_head = (io.uart_in_head + 1) % sizeof(io.uart_in);
+            io.uart_in_len--;
+            return ((uint32_t) io.uart_in_len << 16) | 0x8000 | c;   /* RAVAIL, RVALID */
+        }
+    }
+    if (off >= IO_SEG_BASE && off < IO_SEG_BASE + 16 * IO_SEG_COUNT && (off & 0xF) == 0) {
+        return io.seg[(off - IO_SEG_BASE) / 16];
+    }
+    return 0;
+}
+
+static void io_write(uint32_t off, uint32_t v) {
+    switch (off) {
+    case IO_LEDS:         io.leds = v & 0x3FF; return;
+    case IO_SW_MASK:      io.sw_mask = v & 0x3FF; return;
+    case IO_SW_EDGE:      io.sw_edge &= ~v; return;
+    case IO_TIMER_STATUS: io.timer_status &= ~TIMER_TO; return;
+    case IO_TIMER_PERL:
+    case IO_TIMER_PERH:
+        // Writing a period register stops the timer and reloads it
+        if (off == IO_TIMER_PERL) {
+            io.timer_period = (io.timer_period & 0xFFFF0000) | (v & 0xFFFF);
+        } else {
+            io.timer_period = (io.timer_period & 0xFFFF) | ((v & 0xFFFF) << 16);
+        }
+        io.timer_status &= ~TIMER_RUN;
+        timer_load();
+        return;
+    case IO_TIMER_CTRL:
+        io.timer_ctrl = v & (TIMER_ITO | TIMER_CONT);
+        if (v & TIMER_STOP) {
+            io.timer_status &= ~TIMER_RUN;
+        } else if (v & TIMER_START) {
+            if (!(io.timer_status & TIMER_RUN)) {
+                timer_load();
+            }
+            io.timer_status |= TIMER_RUN;
+        }
+        return;
+    case IO_UART_DATA:
+        if (io.uart_tx_fill == UART_FIFO) {
+            io.uart_dropped++;   /* Lost, like on the board */
+            return;
+        }
+        if (uart_rate) {
+            io.uart_tx_fill++;
+        }
+        io.uart_out++;
+        if (!quiet) {
+            putchar(v & 0xFF);
+        }
+        return;
+    }
+    if (off >= IO_SEG_BASE && off < IO_SEG_BASE + 16 * IO_SEG_COUNT && (off & 0xF) == 0) {
+        io.seg[(off - IO_SEG_BASE) / 16] = v;
+    }
+}
+
+// Advances the interval timer, which runs off the CPU clock
+static void timer_tick(unsigned cycles) {
+    if (!(io.timer_status & TIMER_RUN)) {
+        return;
+    }
+    if (io.timer_count > cycles) {
+        io.timer_count -= cycles;
+        return;
+    }
+    io.timer_status |= TIMER_TO;
+    if (io.timer_ctrl & TIMER_CONT) {
+        timer_load();
+    } else {
+        io.timer_status &= ~TIMER_RUN;
+    }
+}
+
+// Drains the JTAG UART's TX FIFO towards the host at uart_rate characters per second
+static void uart_tick(unsigned cycles) {
+    if (io.uart_tx_fill == 0) {
+        return;
+    }
+    io.uart_tx_credit += (uint64_t) cycles * uart_rate;
+    while (io.uart_tx_fill > 0 && io.uart_tx_credit >= CPU_HZ) {
+        io.uart_tx_credit -= CPU_HZ;
+        io.uart_tx_fill--;
+    }
+    if (io.uart_tx_fill == 0) {
+        io.uart_tx_credit = 0;   /* An idle line does not bank time */
+    }
+}
+
+// Advances everything that runs off the CPU clock
+static void io_tick(unsigned cycles) {
+    timer_tick(cycles);
+    uart_tick(cycles);
+}
+
+static uint32_t pending_irqs(void) {
+    uint32_t pending = 0;
+    if ((io.timer_status & TIMER_TO) && (io.timer_ctrl & TIMER_ITO)) {
+        pending |= 1u << IRQ_TIMER;
+    }
+    if (io.sw_edge & io.sw_mask) {
+        pending |= 1u << IRQ_SWITCH;
+    }
+    return pending;
+}
+
+static void set_switches(uint32_t value) {
+    value &= 0x3FF;
+    io.sw_edge |= value ^ io.switches;
+    io.switches = value;
+}
+
+// --- Memory -------------------------------------------------------------
+
+static int in_io(uint32_t addr) {
+    return addr - DTEKV_IO_BASE < DTEKV_IO_SIZE;
+}
+
+static int in_vga(uint32_t addr) {
+    return addr - DTEKV_VGA_BASE < DTEKV_VGA_SIZE;
+}
+
+static uint32_t load(uint32_t addr, int size, unsigned *extra) {
+    cpu.mem_ops++;
+    if (addr < RAM_SIZE && addr + size <= RAM_SIZE) {
+        uint32_t v = 0;
+        memcpy(&v, ram + addr, size);   /* little-endian host */
+        return v;
+    }
+    *extra += costs[C_IO].cycles;
+    if (in_vga(addr)) {
+        uint32_t v = 0;
+        for (int i = 0; i < size && in_vga(addr + i); i++) {
+            v |= (uint32_t) vga[addr + i - DTEKV_VGA_BASE] << (8 * i);
+        }
+        return v;
+    }
+    if (in_io(addr)) {
+        uint32_t off = addr - DTEKV_IO_BASE;
+        return io_read(off & ~3u) >> (8 * (off & 3));
+    }
+    fatal("load from unmapped address", addr);
+    return 0;
+}
+
+static void store(uint32_t addr, int size, uint32_t v, unsigned *extra) {
+    cpu.mem_ops++;
+    if (addr < RAM_SIZE && addr + size <= RAM_SIZE) {
+        memcpy(ram + addr, &v, size);
+        return;
+    }
+    *extra += costs[C_IO].cycles;
+    if (in_vga(addr)) {
+        for (int i = 0; i < size && in_vga(addr + i); i++) {
+            vga[addr + i - DTEKV_VGA_BASE] = v >> (8 * i);
+        }
+        return;
+    }
+    if (in_io(addr)) {
+        io_write(addr - DTEKV_IO_BASE, v);
+        return;
+    }
+    fatal("store to unmapped address", addr);
+}
+
+// --- Traps and CSRs -----------------------------------------------------
+
+static void record(IsrStats *s, uint64_t cycles) {
+    if (s->count == 0 || cycles < s->min) {
+        s->min = cycles;
+    }
+    if (cycles > s->max) {
+        s->max = cycles;
+    }
+    s->count++;
+    s->total += cycles;
+    int bucket = 0;
+    while ((2ull << bucket) <= cycles && bucket < 39) {
+        bucket++;
+    }
+    s->log2_hist[bucket]++;
+}
+
+static void trap(uint32_t cause, uint32_t epc, uint32_t tval) {
+    cpu.mepc = epc;
+    cpu.mcause = cause;
+    cpu.mtval = tval;
+    cpu.mstatus = (cpu.mstatus & ~MSTATUS_MPIE) | ((cpu.mstatus & MSTATUS_MIE) ? MSTATUS_MPIE : 0);
+    cpu.mstatus &= ~MSTATUS_MIE;
+    cpu.pc = cpu.mtvec & ~3u;
+    cpu.cycles += costs[C_TRAP].cycles;
+    io_tick(costs[C_TRAP].cycles);
+
+    if (!in_trap) {
+        in_trap = 1;
+        trap_cause = cause;
+        trap_start = cpu.cycles - costs[C_TRAP].cycles;
+    }
+}
+
+static void trap_return(void) {
+    cpu.pc = cpu.mepc;
+    cpu.mstatus = (cpu.mstatus & MSTATUS_MPIE) ? (cpu.mstatus | MSTATUS_MIE) : (cpu.mstatus & ~MSTATUS_MIE);
+    cpu.mstatus |= MSTATUS_MPIE;
+
+    if (in_trap) {
+        in_trap = 0;
+        uint64_t cycles = cpu.cycles - trap_start;
+        if (trap_cause & 0x80000000u) {
+            record(&isr_stats[trap_cause & (NUM_CAUSES - 1)], cycles);
+        } else {
+            record(&exc_stats, cycles);
+        }
+    }
+}
+
+static int csr_read(uint32_t csr, uint32_t *v) {
+    switch (csr) {
+    case 0x300: *v = cpu.mstatus; return 1;
+    case 0x301: *v = 0x40001100; return 1;   /* misa: RV32IM */
+    case 0x304: *v = cpu.mie; return 1;
+    case 0x305: *v = cpu.mtvec; return 1;
+    case 0x340: *v = cpu.mscratch; return 1;
+    case 0x341: *v = cpu.mepc; return 1;
+    case 0x342: *v = cpu.mcause; return 1;
+    case 0x343: *v = cpu.mtval; return 1;
+    case 0x344: *v = pending_irqs(); return 1;
+    case 0xF14: *v = 0; return 1;             /* mhartid */
+    case 0xB00: case 0xC00: *v = (uint32_t) cpu.cycles; return 1;
+    case 0xB80: case 0xC80: *v = (uint32_t) (cpu.cycles >> 32); return 1;
+    case 0xB02: case 0xC02: *v = (uint32_t) cpu.instret; return 1;
+    case 0xB82: case 0xC82: *v = (uint32_t) (cpu.instret >> 32); return 1;
+    case 0xB03: *v = (uint32_t) cpu.mem_ops; return 1;
+    }
+    if (csr >= 0xB04 && csr <= 0xB1F) {
+        *v = 0;   /* cache and stall counters: not modelled */
+        return 1;
+    }
+    return 0;
+}
+
+static void csr_write(uint32_t csr, uint32_t v) {
+    switch (csr) {
+    case 0x300: cpu.mstatus = v & (MSTATUS_MIE | MSTATUS_MPIE); break;
+    case 0x304: cpu.mie = v; break;
+    case 0x305: cpu.mtvec = v; break;
+    case 0x340: cpu.mscratch = v; break;
+    case 0x341: cpu.mepc = v & ~1u; break;
+    case 0x342: cpu.mcause = v; break;
+    case 0x343: cpu.mtval = v; break;
+    }
+}
+
+// --- Execution ----------------------------------------------------------
+
+static inline int32_t sext(uint32_t v, int bits) {
+    return (int32_t) (v << (32 - bits)) >> (32 - bits);
+}
+
+/*
+ * Executes one instruction.
+ * @return 0 to keep going, 1 if the program stopped (ebreak or a jump-to-self
+ * with interrupts off, like the loop after main in boot.S)
+ */
+static int step(void) {
+    uint32_t pc = cpu.pc;
+    if (pc >= RAM_SIZE - 3 || (pc & 3)) {
+        fatal("instruction fetch from", pc);
+    }
+    uint32_t inst;
+    memcpy(&inst, ram + pc, 4);
+
+    uint32_t op = inst & 0x7F;
+    uint32_t rd = (inst >> 7) & 0x1F;
+    uint32_t f3 = (inst >> 12) & 0x7;
+    uint32_t rs1 = (inst >> 15) & 0x1F;
+    uint32_t rs2 = (inst >> 20) & 0x1F;
+    uint32_t f7 = inst >> 25;
+    uint32_t a = cpu.x[rs1];
+    uint32_t b = cpu.x[rs2];
+    int32_t imm_i = (int32_t) inst >> 20;
+    int32_t imm_s = sext(((inst >> 25) << 5) | ((inst >> 7) & 0x1F), 12);
+    int32_t imm_b = sext(((inst >> 31) << 12) | (((inst >> 7) & 1) << 11) |
+                         (((inst >> 25) & 0x3F) << 5) | (((inst >> 8) & 0xF) << 1), 13);
+    int32_t imm_j = sext(((inst >> 31) << 20) | (((inst >> 12) & 0xFF) << 12) |
+                         (((inst >> 20) & 1) << 11) | (((inst >> 21) & 0x3FF) << 1), 21);
+
+    uint32_t next = pc + 4;
+    uint32_t result = 0;
+    int write = 1;
+    unsigned cycles = costs[C_ALU].cycles;
+    unsigned extra = 0;
+
+    switch (op) {
+    case 0x37: result = inst & 0xFFFFF000; break;                 /* lui */
+    case 0x17: result = pc + (inst & 0xFFFFF000); break;          /* auipc */
+    case 0x6F:                                                    /* jal */
+        result = next;
+        next = pc + imm_j;
+        cycles = costs[C_JUMP].cycles;
+        if (imm_j == 0 && !(cpu.mstatus & MSTATUS_MIE)) {
+            return 1;
+        }
+        break;
+    case 0x67:                                                    /* jalr */
+        result = next;
+        next = (a + imm_i) & ~1u;
+        cycles = costs[C_JUMP].cycles;
+        break;
+    case 0x63: {                                                  /* branches */
+        int taken;
+        switch (f3) {
+        case 0: taken = a == b; break;
+        case 1: taken = a != b; break;
+        case 4: taken = (int32_t) a < (int32_t) b; break;
+        case 5: taken = (int32_t) a >= (int32_t) b; break;
+        case 6: taken = a < b; break;
+        case 7: taken = a >= b; break;
+        default: goto illegal;
+        }
+        write = 0;
+        cycles = costs[C_BRANCH].cycles;
+        if (taken) {
+            next = pc + imm_b;
+            cycles += costs[C_TAKEN].cycles;
+        }
+        break;
+    }
+    case 0x03: {                                                  /* loads */
+        uint32_t addr = a + imm_i;
+        cycles = costs[C_LOAD].cycles;
+        switch (f3) {
+        case 0: result = sext(load(addr, 1, &extra), 8); break;
+        case 1: result = sext(load(addr, 2, &extra), 16); break;
+        case 2: result = load(addr, 4, &extra); break;
+        case 4: result = load(addr, 1, &extra) & 0xFF; break;
+        case 5: result = load(addr, 2, &extra) & 0xFFFF; break;
+        default: goto illegal;
+        }
+        break;
+    }
+    case 0x23: {                                                  /* stores */
+        uint32_t addr = a + imm_s;
+        cycles = costs[C_STORE].cycles;
+        write = 0;
+        switch (f3) {
+        case 0: store(addr, 1, b, &extra); break;
+        case 1: store(addr, 2, b, &extra); break;
+        case 2: store(addr, 4, b, &extra); break;
+        default: goto illegal;
+        }
+        break;
+    }
+    case 0x13: {                                                  /* op-imm */
+        uint32_t shamt = rs2;
+        switch (f3) {
+        case 0: result = a + imm_i; break;
+        case 1: result = a << shamt; break;
+        case 2: result = (int32_t) a < imm_i; break;
+        case 3: result = a < (uint32_t) imm_i; break;
+        case 4: result = a ^ imm_i; break;
+        case 5: result = (f7 & 0x20) ? (uint32_t) ((int32_t) a >> shamt) : a >> shamt; break;
+        case 6: result = a | imm_i; break;
+        case 7: result = a & imm_i; break;
+        }
+        break;
+    }
+    case 0x33:                                                    /* op */
+        if (f7 == 1) {                                            /* M extension */
+            cycles = costs[f3 < 4 ? C_MUL : C_DIV].cycles;
+            switch (f3) {
+            case 0: result = a * b; break;
+            case 1: result = (uint32_t) (((int64_t) (int32_t) a * (int32_t) b) >> 32); break;
+            case 2: result = (uint32_t) (((int64_t) (int32_t) a * (uint64_t) b) >> 32); break;
+            case 3: result = (uint32_t) (((uint64_t) a * b) >> 32); break;
+            case 4:
+                result = b == 0 ? 0xFFFFFFFF
+                       : (a == 0x80000000 && b == 0xFFFFFFFF) ? a
+                       : (uint32_t) ((int32_t) a / (int32_t) b);
+                break;
+            case 5: result = b == 0 ? 0xFFFFFFFF : a / b; break;
+            case 6:
+                result = b == 0 ? a
+                       : (a == 0x80000000 && b == 0xFFFFFFFF) ? 0
+                       : (uint32_t) ((int32_t) a % (int32_t) b);
+                break;
+            case 7: result = b == 0 ? a : a % b; break;
+            }
+            break;
+        }
+        switch (f3) {
+        case 0: result = (f7 & 0x20) ? a - b : a + b; break;
+        case 1: result = a << (b & 31); break;
+        case 2: result = (int32_t) a < (int32_t) b; break;
+        case 3: result = a < b; break;
+        case 4: result = a ^ b; break;
+        case 5: result = (f7 & 0x20) ? (uint32_t) ((int32_t) a >> (b & 31)) : a >> (b & 31); break;
+        case 6: result = a | b; break;
+        case 7: result = a & b; break;
+        }
+        break;
+    case 0x0F:                                                    /* fence */
+        write = 0;
+        cycles = costs[C_CSR].cycles;
+        break;
+    case 0x73:                                                    /* system */
+        cycles = costs[C_CSR].cycles;
+        if (f3 == 0) {
+            write = 0;
+            if (inst == 0x00000073) {                             /* ecall */
+                cpu.cycles += cycles;
+                cpu.instret++;
+                io_tick(cycles);
+                trap(11, pc, 0);
+                return 0;
+            } else if (inst == 0x00100073) {                      /* ebreak */
+                return 1;
+            } else if (inst == 0x30200073) {                      /* mret */
+                cpu.cycles += cycles;
+                cpu.instret++;
+                io_tick(cycles);
+                trap_return();
+                return 0;
+            } else if (inst == 0x10500073) {                      /* wfi */
+                break;
+            }
+            goto illegal;
+        } else {
+            uint32_t csr = inst >> 20;
+            uint32_t src = (f3 & 4) ? rs1 : a;                    /* csr*i take rs1 as an immediate */
+            uint32_t old;
+            if (!csr_read(csr, &old)) {
+                goto illegal;
+            }
+            switch (f3 & 3) {
+            case 1: csr_write(csr, src); break;
+            case 2: if (rs1) csr_write(csr, old | src); break;
+            case 3: if (rs1) csr_write(csr, old & ~src); break;
+            default: goto illegal;
+            }
+            result = old;
+        }
+        break;
+    default:
+        goto illegal;
+    }
+
+    if (write && rd) {
+        cpu.x[rd] = result;
+    }
+    cpu.pc = next;
+    cycles += extra;
+    cpu.cycles += cycles;
+    cpu.instret++;
+    io_tick(cycles);
+    return 0;
+
+illegal:
+    trap(2, pc, inst);
+    return 0;
+}
+
+// Takes a pending, enabled interrupt if interrupts are on
+static void check_interrupts(void) {
+    if (!(cpu.mstatus & MSTATUS_MIE)) {
+        return;
+    }
+    uint32_t ready = pending_irqs() & cpu.mie;
+    if (!ready) {
+        return;
+    }
+    uint32_t cause = 0;
+    while (!(ready & (1u << cause))) {
+        cause++;
+    }
+    trap(0x80000000u | cause, cpu.pc, 0);
+}
+
+// --- ELF loading --------------------------------------------------------
+
+static uint32_t rd32(const uint8_t *p) { return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t) p[3] << 24; }
+static uint16_t rd16(const uint8_t *p) { return p[0] | p[1] << 8; }
+
+static void load_elf(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *elf = malloc(size);
+    if (!elf || fread(elf, 1, size, f) != (size_t) size) {
+        fprintf(stderr, "%s: read failed\n", path);
+        exit(1);
+    }
+    fclose(f);
+
+    if (size < 52 || memcmp(elf, "\177ELF", 4) != 0 || elf[4] != 1 || elf[5] != 1 || rd16(elf + 18) != 243) {
+        fprintf(stderr, "%s: not a 32-bit little-endian RISC-V ELF\n", path);
+        exit(1);
+    }
+    uint32_t phoff = rd32(elf + 28);
+    uint16_t phentsize = rd16(elf + 42);
+    uint16_t phnum = rd16(elf + 44);
+    for (int i = 0; i < phnum; i++) {
+        const uint8_t *ph = elf + phoff + i * phentsize;
+        if (ph + 32 > elf + size || rd32(ph) != 1) {              /* PT_LOAD */
+            continue;
+        }
+        uint32_t offset = rd32(ph + 4), paddr = rd32(ph + 12);
+        uint32_t filesz = rd32(ph + 16), memsz = rd32(ph + 20);
+        if ((uint64_t) paddr + memsz > RAM_SIZE || (uint64_t) offset + filesz > (uint64_t) size) {
+            fprintf(stderr, "%s: segment at 0x%08X does not fit in RAM\n", path, paddr);
+            exit(1);
+        }
+        memcpy(ram + paddr, elf + offset, filesz);
+        memset(ram + paddr + filesz, 0, memsz - filesz);
+    }
+    cpu.pc = rd32(elf + 24);
+    free(elf);
+}
+
+// --- Script -------------------------------------------------------------
+
+typedef struct {
+    uint64_t at;
+    char command[16];
+    char arg[256];
+} Event;
+
+static Event *events;
+static int num_events, next_event;
+
+// Parses "123", "10ms" or "1.5s" into cycles
+static int parse_time(const char *s, uint64_t *cycles) {
+    char *end;
+    double v = strtod(s, &end);
+    if (end == s || v < 0) {
+        return 0;
+    }
+    if (strcmp(end, "ms") == 0) {
+        v *= CPU_HZ / 1000.0;
+    } else if (strcmp(end, "s") == 0) {
+        v *= CPU_HZ;
+    } else if (*end != '\0') {
+        return 0;
+    }
+    *cycles = (uint64_t) (v + 0.5);
+    return 1;
+}
+
+static void load_script(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    char line[512];
+    int lineno = 0;
+    int capacity = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        char time[32] = "", command[16] = "", arg[256] = "";
+        char *hash = strchr(line, '#');
+        if (hash) {
+            *hash = '\0';
+        }
+        if (sscanf(line, "%31s %15s %255[^\n]", time, command, arg) < 2) {
+            continue;
+        }
+        Event e;
+        if (!parse_time(time, &e.at)) {
+            fprintf(stderr, "%s:%d: bad time '%s'\n", path, lineno, time);
+            exit(1);
+        }
+        if (num_events > 0 && e.at < events[num_events - 1].at) {
+            fprintf(stderr, "%s:%d: events must be in time order\n", path, lineno);
+            exit(1);
+        }
+        strcpy(e.command, command);
+        strcpy(e.arg, arg);
+        if (num_events == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            events = realloc(events, capacity * sizeof(Event));
+        }
+        events[num_events++] = e;
+    }
+    fclose(f);
+}
+
+static void write_ppm(const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        return;
+    }
+    fprintf(f, "P6\n%d %d\n255\n", VGA_WIDTH, VGA_HEIGHT);
+    for (int i = 0; i < VGA_WIDTH * VGA_HEIGHT; i++) {
+        uint8_t c = vga[i];
+        uint8_t rgb[3] = {((c >> 5) & 7) * 255 / 7, ((c >> 2) & 7) * 255 / 7, (c & 3) * 255 / 3};
+        fwrite(rgb, 1, 3, f);
+    }
+    fclose(f);
+}
+
+static void report(void);
+
+// Applies one scripted event; returns 1 to stop the run
+static int apply_event(const Event *e) {
+    if (strcmp(e->command, "sw") == 0) {
+        set_switches(strtoul(e->arg, NULL, 0));
+    } else if (strcmp(e->command, "btn") == 0) {
+        io.buttons = strtoul(e->arg, NULL, 0) & 0xF;
+    } else if (strcmp(e->command, "uart") == 0) {
+        for (const char *p = e->arg; *p; p++) {
+            char c = *p;
+            if (c == '\\' && p[1] == 'n') {
+                c = '\n';
+                p++;
+            }
+            if (io.uart_in_len < (int) sizeof(io.uart_in)) {
+                io.uart_in[(io.uart_in_head + io.uart_in_len) % sizeof(io.uart_in)] = c;
+                io.uart_in_len++;
+            }
+        }
+    } else if (strcmp(e->command, "dump") == 0) {
+        write_ppm(e->arg);
+    } else if (strcmp(e->command, "report") == 0) {
+        report();
+    } else if (strcmp(e->command, "quit") == 0) {
+        return 1;
+    } else {
+        fprintf(stderr, "dtekv-sim: unknown script command '%s'\n", e->command);
+        exit(1);
+    }
+    return 0;
+}
+
+// --- Reporting ----------------------------------------------------------
+
+static void print_stats(const char *name, const IsrStats *s) {
+    if (s->count == 0) {
+        return;
+    }
+    printf("  %-10s %8llu calls  avg %8llu  min %8llu  max %8llu cycles\n", name,
+           (unsigned long long) s->count, (unsigned long long) (s->total / s->count),
+           (unsigned long long) s->min, (unsigned long long) s->max);
+    for (int i = 0; i < 40; i++) {
+        if (s->log2_hist[i]) {
+            printf("  %10s %8llu in [%llu, %llu)\n", "",
+                   (unsigned long long) s->log2_hist[i],
+                   i ? 1ull << i : 0ull, 2ull << i);
+        }
+    }
+}
+
+static void report(void) {
+    uint64_t busy = 0;
+    printf("\n== dtekv-sim: %llu cycles (%.3f s), %llu instructions, CPI %.2f, %llu UART chars (%llu dropped)\n",
+           (unsigned long long) cpu.cycles, (double) cpu.cycles / CPU_HZ,
+           (unsigned long long) cpu.instret,
+           cpu.instret ? (double) cpu.cycles / cpu.instret : 0.0,
+           (unsigned long long) io.uart_out, (unsigned long long) io.uart_dropped);
+    printf("  handler cycles per invocation (trap entry to mret):\n");
+    for (int c = 0; c < NUM_CAUSES; c++) {
+        char name[16];
+        snprintf(name, sizeof(name), c == IRQ_TIMER ? "timer" : c == IRQ_SWITCH ? "switch" : "irq %d", c);
+        print_stats(name, &isr_stats[c]);
+        busy += isr_stats[c].total;
+    }
+    print_stats("exception", &exc_stats);
+    if (cpu.cycles) {
+        printf("  time in interrupt handlers: %.2f%%\n", 100.0 * busy / cpu.cycles);
+    }
+    printf("  7-seg:");
+    for (int i = IO_SEG_COUNT - 1; i >= 0; i--) {
+        printf(" %02X", io.seg[i] & 0xFF);
+    }
+    printf("  LEDs: %03X\n", io.leds);
+}
+
+// --- Main ---------------------------------------------------------------
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [-s script] [-t time] [-q] [--cost class=n,...] [--uart-rate n] [--ppm file] main.elf\n"
+                    "  -s script   scripted inputs (see the top of host/dtekv-sim.c)\n"
+                    "  -t time     stop after this long (cycles, or with ms/s), default 10s\n"
+                    "  -q          do not echo the JTAG UART\n"
+                    "  --uart-rate JTAG UART TX drain in characters per second, default %d (0: never full)\n"
+                    "  --ppm file  write the final framebuffer as a PPM image\n"
+                    "  --cost      cycles per instruction class; classes and defaults:\n", argv0, UART_RATE);
+    for (int i = 0; i < NUM_COSTS; i++) {
+        fprintf(stderr, "                %-7s %2u  %s\n", costs[i].name, costs[i].cycles, costs[i].help);
+    }
+    exit(2);
+}
+
+static void parse_costs(char *spec, const char *argv0) {
+    for (char *item = strtok(spec, ","); item; item = strtok(NULL, ",")) {
+        char *eq = strchr(item, '=');
+        int found = 0;
+        if (eq) {
+            *eq = '\0';
+            for (int i = 0; i < NUM_COSTS; i++) {
+                if (strcmp(costs[i].name, item) == 0) {
+                    costs[i].cycles = strtoul(eq + 1, NULL, 0);
+                    found = 1;
+                }
+            }
+        }
+        if (!found) {
+            fprintf(stderr, "bad cost '%s'\n", item);
+            usage(argv0);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *elf_path = NULL, *script_path = NULL, *ppm_path = NULL;
+    uint64_t limit = 10ull * CPU_HZ;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            script_path = argv[++i];
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            if (!parse_time(argv[++i], &limit)) {
+                usage(argv[0]);
+            }
+        } else if (strcmp(argv[i], "-q") == 0) {
+            quiet = 1;
+        } else if (strcmp(argv[i], "--cost") == 0 && i + 1 < argc) {
+            parse_costs(argv[++i], argv[0]);
+        } else if (strcmp(argv[i], "--uart-rate") == 0 && i + 1 < argc) {
+            uart_rate = strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--ppm") == 0 && i + 1 < argc) {
+            ppm_path = argv[++i];
+        } else if (argv[i][0] != '-' && !elf_path) {
+            elf_path = argv[i];
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (!elf_path) {
+        usage(argv[0]);
+    }
+
+    ram = calloc(RAM_SIZE, 1);
+    if (!ram) {
+        perror("RAM");
+        return 1;
+    }
+    load_elf(elf_path);
+    if (script_path) {
+        load_script(script_path);
+    }
+
+    int stopped = 0;
+    while (!stopped && cpu.cycles < limit) {
+        while (next_event < num_events && events[next_event].at <= cpu.cycles && !stopped) {
+            stopped = apply_event(&events[next_event++]);
+        }
+        if (!stopped) {
+            check_interrupts();
+            stopped = step();
+        }
+    }
+
+    fflush(stdout);
+    report();
+    if (ppm_path) {
+        write_ppm(ppm_path);
+    }
+    return 0;
+}
@@ -0,0 +1,26 @@
+/*
+ * Host stand-ins for the DTEK-V hardware, used with -DDTEKV_HOST.
+ * The I/O and VGA windows are plain arrays (see dtekv-hal.h), the assembly
+ * helpers from boot.S do nothing and dtekv-lib output goes to stdout.
+ */
+#include <stdio.h>
+#include "../dtekv-hal.h"
+#include "../dtekv-lib.h"
+
+volatile uint32_t hal_io_space[DTEKV_IO_SIZE / 4];
+volatile uint8_t hal_vga_space[DTEKV_VGA_SIZE];
+HalStoreCounters hal_stores;
+uint32_t hal_cycles;
+
+void enable_interrupt(void) {}
+void enable_switch_interrupts(void) {}
+void enable_timer_interrupts(void) {}
+
+void printc(char c) { putchar(c); }
+void print(char *s) { fputs(s, stdout); }
+void print_dec(unsigned int x) { printf("%u", x); }
+void print_hex32(unsigned int x) { printf("0x%08X", x); }
+int readc(void) { return -1; }
+int print_space(void) { return 64; }
+int print_report_start(print_piece_fn report) { for (int n = 0; report(n); n++) {} return 1; }
+int print_report_poll(void) { return 0; }
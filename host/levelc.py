@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+"""Level compiler: turns ASCII level layouts into run-length encoded C tables.
+
+Each input file is LEVEL_HEIGHT lines of LEVEL_WIDTH characters, '#' for a
+wall cell and '.' for open floor. Every row is stored as alternating run
+lengths, starting with an open run (which may be 0), until the runs add up
+to the level width. The output is a C file for snake-level.c:
+
+    python3 host/levelc.py -o snake-levels.c levels/*.txt
+"""
+import argparse
+import os
+import sys
+
+LEVEL_WIDTH = 32
+LEVEL_HEIGHT = 24
+
+
+def parse_level(path):
+    with open(path) as f:
+        rows = [line.rstrip("\n") for line in f if line.strip()]
+    if len(rows) != LEVEL_HEIGHT:
+        sys.exit(f"{path}: expected {LEVEL_HEIGHT} rows, got {len(rows)}")
+    for y, row in enumerate(rows):
+        if len(row) != LEVEL_WIDTH:
+            sys.exit(f"{path}:{y + 1}: expected {LEVEL_WIDTH} columns, got {len(row)}")
+        bad = set(row) - set("#.")
+        if bad:
+            sys.exit(f"{path}:{y + 1}: unexpected characters {''.join(sorted(bad))!r}")
+    return rows
+
+
+def encode_row(row):
+    runs = []
+    wall = False
+    x = 0
+    while x < len(row):
+        start = x
+        while x < len(row) and (row[x] == "#") == wall:
+            x += 1
+        runs.append(x - start)
+        wall = not wall
+    return runs
+
+
+def level_name(path):
+    base = os.path.splitext(os.path.basename(path))[0]
+    # "01-pillars" -> "pillars"
+    return base.split("-", 1)[-1]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("-o", "--output", required=True, help="C file to write")
+    parser.add_argument("levels", nargs="+", help="level layouts, in play order")
+    args = parser.parse_args()
+
+    out = []
+    out.append("// Generated by host/levelc.py from the layouts in levels/ - do not edit.")
+    out.append("// Regenerate with: make levels")
+    out.append("")
+    out.append('#include "snake-level.h"')
+    out.append("")
+
+    entries = []
+    total = 0
+    for i, path in enumerate(args.levels):
+        rows = parse_level(path)
+        data = []
+        for row in rows:
+            data.extend(encode_row(row))
+        total += len(data)
+        name = level_name(path)
+        out.append(f"// {name}: {sum(r.count('#') for r in rows)} wall cells")
+        out.append(f"static const uint8_t level_{i}_rle[{len(data)}] = {{")
+        for start in range(0, len(data), 16):
+            out.append("    " + ", ".join(str(v) for v in data[start:start + 16]) + ",")
+        out.append("};")
+        out.append("")
+        entries.append(f'    {{"{name}", level_{i}_rle}},')
+
+    out.append(f"// {total} bytes of run lengths for {len(entries)} levels")
+    out.append("const LevelData level_table[] = {")
+    out.extend(entries)
+    out.append("};")
+    out.append("")
+    out.append(f"const int level_count = {len(entries)};")
+
+    with open(args.output, "w") as f:
+        f.write("\n".join(out) + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+"""Memory report: sizes of the symbols in main.elf, grouped by section.
+
+Runs nm on the ELF (or reads saved `nm -S` output) and prints, for each of
+.text, .rodata, .data and .bss, the total size and the largest symbols, so
+it is clear what the RAM goes to before shrinking any reservation:
+
+    python3 host/memreport.py --nm riscv32-unknown-elf-nm main.elf
+    python3 host/memreport.py --top 5 main.elf
+"""
+import argparse
+import subprocess
+import sys
+
+# nm type letters (either case) for each section; g/s are RISC-V small data/bss
+SECTIONS = [
+    (".text", "t"),
+    (".rodata", "r"),
+    (".data", "dg"),
+    (".bss", "bsc"),
+]
+
+
+def read_symbols(args):
+    if args.elf.endswith(".elf"):
+        cmd = [args.nm, "-S", "--size-sort", args.elf]
+        try:
+            out = subprocess.run(cmd, check=True, capture_output=True, text=True).stdout
+        except (OSError, subprocess.CalledProcessError) as e:
+            sys.exit(f"{' '.join(cmd)}: {e}")
+    else:
+        with open(args.elf) as f:
+            out = f.read()
+
+    symbols = []
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) != 4:
+            continue  # No size: labels, linker symbols
+        _, size, kind, name = fields
+        symbols.append((int(size, 16), kind.lower(), name))
+    return symbols
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="main.elf, or a file holding `nm -S` output")
+    parser.add_argument("--nm", default="riscv32-unknown-elf-nm", help="nm to run on the ELF")
+    parser.add_argument("--top", type=int, default=10, help="symbols to list per section")
+    args = parser.parse_args()
+
+    symbols = read_symbols(args)
+    for section, kinds in SECTIONS:
+        group = sorted((s for s in symbols if s[1] in kinds), reverse=True)
+        total = sum(size for size, _, _ in group)
+        print(f"{section:8} {total:9d} bytes in {len(group)} symbols")
+        for size, _, name in group[:args.top]:
+            print(f"  {size:9d}  {name}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+"""PC-sampling profile report: maps a histogram dumped by dtekv-prof.c to functions.
+
+Build with `make PROFILE=1`, play for a while, send 'f' on the JTAG UART and
+save the console output. The last complete dump in the log is attributed to
+functions using the symbols in the objdump listing the Makefile writes:
+
+    python3 host/pcprof.py main.elf.txt uart.log
+    python3 host/pcprof.py main.elf.txt uart.log --buckets 20
+"""
+import argparse
+import bisect
+import re
+import sys
+
+SYMBOL_RE = re.compile(r"^([0-9a-fA-F]+) <([^>]+)>:")
+SECTION_RE = re.compile(r"^Disassembly of section (\S+):")
+BEGIN_RE = re.compile(r"\[prof\] begin shift=(\d+) samples=(\d+) outside=(\d+)")
+BUCKET_RE = re.compile(r"^0x([0-9a-fA-F]+) (\d+)$")
+
+
+def read_symbols(path):
+    """Returns sorted (address, name) pairs for the symbols in .text."""
+    symbols = []
+    section = None
+    with open(path) as f:
+        for line in f:
+            m = SECTION_RE.match(line)
+            if m:
+                section = m.group(1)
+                continue
+            m = SYMBOL_RE.match(line)
+            if m and section == ".text":
+                symbols.append((int(m.group(1), 16), m.group(2)))
+    symbols.sort()
+    return symbols
+
+
+def read_dump(path):
+    """Returns (shift, samples, outside, {address: count}) for the last complete dump."""
+    result = None
+    current = None
+    with open(path, errors="replace") as f:
+        for line in f:
+            line = line.strip()
+            m = BEGIN_RE.search(line)
+            if m:
+                current = (int(m.group(1)), int(m.group(2)), int(m.group(3)), {})
+                continue
+            if current is None:
+                continue
+            if line.endswith("[prof] end"):
+                result = current
+                current = None
+                continue
+            m = BUCKET_RE.match(line)
+            if m:
+                current[3][int(m.group(1), 16)] = int(m.group(2))
+    if result is None:
+        sys.exit(f"{path}: no complete [prof] dump found")
+    return result
+
+
+def locate(symbols, addresses, address):
+    """Returns (name, offset) of the function containing address."""
+    i = bisect.bisect_right(addresses, address) - 1
+    if i < 0:
+        return "?", address
+    return symbols[i][1], address - symbols[i][0]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("listing", help="objdump listing of main.elf (main.elf.txt)")
+    parser.add_argument("log", help="UART log holding a [prof] dump")
+    parser.add_argument("--buckets", type=int, default=0, metavar="N",
+                        help="also list the N hottest address buckets")
+    args = parser.parse_args()
+
+    symbols = read_symbols(args.listing)
+    if not symbols:
+        sys.exit(f"{args.listing}: no .text symbols found")
+    addresses = [a for a, _ in symbols]
+    shift, samples, outside, buckets = read_dump(args.log)
+
+    per_function = {}
+    for address, count in buckets.items():
+        name, _ = locate(symbols, addresses, address)
+        per_function[name] = per_function.get(name, 0) + count
+
+    total = sum(buckets.values()) + outside
+    print(f"{samples} samples, {outside} outside .text, {1 << shift}-byte buckets")
+    if total == 0:
+        return
+    print(f"{'samples':>8} {'%':>6} {'cum %':>6}  function")
+    cumulative = 0
+    for name, count in sorted(per_function.items(), key=lambda kv: -kv[1]):
+        cumulative += count
+        print(f"{count:8d} {100 * count / total:6.2f} {100 * cumulative / total:6.2f}  {name}")
+
+    if args.buckets:
+        print()
+        print(f"{'samples':>8} {'address':>10}  location")
+        hottest = sorted(buckets.items(), key=lambda kv: -kv[1])[:args.buckets]
+        for address, count in hottest:
+            name, offset = locate(symbols, addresses, address)
+            print(f"{count:8d} {address:#010x}  {name}+{offset:#x}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,295 @@
+/*
+ * Render-bandwidth benchmark.
+ *
+ * Builds the game against the host HAL (-DDTEKV_HOST), renders a fixed set
+ * of screens and reports how many stores and bytes each frame sends to the
+ * framebuffer and to the peripheral registers. The final frame of every
+ * screen is compared with a golden PPM so rendering optimisations cannot
+ * silently change what ends up on the display.
+ *
+ *   render-bench <golden-dir>            compare against golden frames
+ *   render-bench <golden-dir> --update   (re)write the golden frames
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Pull in the whole game so the bench can set up its state directly
+#define main dtekv_main
+#include "../labmain.c"
+#undef main
+
+#define PPM_SIZE (DTEKV_VGA_SIZE * 3)
+
+/**
+ * @brief Lays a snake out along a boustrophedon path starting at grid row row0.
+ * Segment 0 (the head) is at the start of the path.
+ */
+static Point path_point(int k, int row0) {
+    int row = row0 + k / GRID_WIDTH;
+    int col = (row % 2 == 0) ? k % GRID_WIDTH : GRID_WIDTH - 1 - k % GRID_WIDTH;
+    return (Point){col, row};
+}
+
+static void lay_snake(int i, int length, int row0) {
+    // Coarse cells (e.g. CELL_SIZE=20) leave less room than the scenarios ask for
+    if (length > (GRID_HEIGHT - row0) * GRID_WIDTH) {
+        length = (GRID_HEIGHT - row0) * GRID_WIDTH;
+    }
+    // Start with just the tail and crawl along the path towards the head
+    store_place(&snakes, i, path_point(length - 1, row0), 1, SNAKE_LEFT);
+    for (int k = length - 2; k >= 0; k--) {
+        Point from = path_point(k + 1, row0);
+        Point to = path_point(k, row0);
+        int code = (to.x < from.x) ? SNAKE_LEFT : (to.x > from.x) ? SNAKE_RIGHT
+                 : (to.y < from.y) ? SNAKE_UP : SNAKE_DOWN;
+        store_push(&snakes, i, code);
+        store_grow(&snakes, i);
+    }
+    snakes.dir[i] = SNAKE_LEFT;
+}
+
+/**
+ * @brief Zeroes the store counters so set-up stores are not charged to the frame.
+ */
+static void begin_frames(void) {
+    memset(&hal_stores, 0, sizeof(hal_stores));
+}
+
+/**
+ * @brief Publishes the state a scenario set up and draws it from scratch,
+ * the way the main loop would after a state change.
+ */
+static void show(void) {
+    publish_frame();
+    shown_state = -1;
+    begin_frames();
+    present();
+}
+
+// --- Scenarios: each sets up state, renders and returns the frame count ---
+
+static int render_menu(void) {
+    current_state = STATE_MENU;
+    menu_selection = 1;
+    show();
+    return 1;
+}
+
+static void start_game(int players) {
+    num_players = players;
+    seed_random(1);
+    reset_game();
+    current_state = STATE_PLAYING;
+    previous_state = STATE_PLAYING;
+}
+
+static int render_play_len3(void) {
+    start_game(1);
+    show();
+    return 1;
+}
+
+static int render_play_len100(void) {
+    start_game(1);
+    lay_snake(0, 100, 0);
+    food = (Point){GRID_WIDTH - 1, GRID_HEIGHT - 1};
+    show();
+    return 1;
+}
+
+static int render_play_len380(void) {
+    start_game(1);
+    lay_snake(0, 380, 0);
+    food = (Point){GRID_WIDTH - 1, GRID_HEIGHT - 1};
+    show();
+    return 1;
+}
+
+static int render_play_2p(void) {
+    start_game(2);
+    lay_snake(0, 150, 0);
+    lay_snake(1, 150, GRID_HEIGHT / 2);
+    food = (Point){GRID_WIDTH - 1, GRID_HEIGHT - 1};
+    show();
+    return 1;
+}
+
+static int render_play_level(void) {
+    start_game(1);
+    load_level(3);
+    food = (Point){GRID_WIDTH / 2, GRID_HEIGHT / 2};
+    show();
+    return 1;
+}
+
+// Twelve single-player steps, each repainting only the cells that changed
+static int render_play_steps(void) {
+    start_game(1);
+    show();
+    begin_frames();
+    int frames = 0;
+    for (; frames < 12 && current_state == STATE_PLAYING; frames++) {
+        update_game();
+        game_step++;
+        publish_frame();
+        present();
+    }
+    return frames;
+}
+
+// Two players, six bots and a replay snake after a few game steps
+static int render_play_8p(void) {
+    // Circles the 3x3 block left of its spawn point
+    static const uint8_t loop[] = {SNAKE_UP, SNAKE_LEFT, SNAKE_LEFT, SNAKE_DOWN,
+                                   SNAKE_DOWN, SNAKE_RIGHT, SNAKE_RIGHT, SNAKE_UP};
+    IO_STORE(SWITCHES, 3 << BOT_SWITCH_SHIFT);
+    start_game(2);
+    IO_STORE(SWITCHES, 0);
+    store_set_script(&snakes, SNAKES_MAX - 1, loop, sizeof(loop));
+    for (int step = 0; step < 8 && current_state == STATE_PLAYING; step++) {
+        update_game();
+        game_step++;
+    }
+    if (current_state != STATE_PLAYING) {
+        fprintf(stderr, "play_8p: game ended early\n");
+    }
+    show();
+    return 1;
+}
+
+// Game over screen plus the whole shrinking-box animation, driven by timer ticks
+static int render_game_over(void) {
+    start_game(2);
+    lay_snake(0, 12, 0);
+    lay_snake(1, 9, GRID_HEIGHT / 2);
+    losing_player = 1;
+    current_state = STATE_GAME_OVER;
+
+    // Fire the timer at each deadline the scheduler asks for and let the
+    // main loop present each published frame
+    int frames = 0;
+    shown_state = -1;
+    begin_frames();
+    do {
+        hal_cycles = sched_next_deadline();
+        handle_interrupt(16);
+        present();
+        frames++;
+    } while (animating_box);
+    return frames;
+}
+
+typedef struct {
+    const char *name;
+    int (*render)(void);
+} Scenario;
+
+static const Scenario scenarios[] = {
+    {"menu",          render_menu},
+    {"play_len3",     render_play_len3},
+    {"play_len100",   render_play_len100},
+    {"play_len380",   render_play_len380},
+    {"play_2p",       render_play_2p},
+    {"play_level",    render_play_level},
+    {"play_steps",    render_play_steps},
+    {"play_8p",       render_play_8p},
+    {"game_over",     render_game_over},
+};
+
+/**
+ * @brief Converts the RGB332 framebuffer to a binary PPM image.
+ */
+static void framebuffer_to_ppm(uint8_t *rgb) {
+    for (int i = 0; i < DTEKV_VGA_SIZE; i++) {
+        uint8_t c = hal_vga_space[i];
+        rgb[i * 3 + 0] = ((c >> 5) & 0x7) * 255 / 7;
+        rgb[i * 3 + 1] = ((c >> 2) & 0x7) * 255 / 7;
+        rgb[i * 3 + 2] = (c & 0x3) * 255 / 3;
+    }
+}
+
+/**
+ * @brief Compares the frame with <dir>/<name>.ppm, or writes it when updating.
+ * @return 1 if the frame matches (or was written), 0 otherwise
+ */
+static int check_golden(const char *dir, const char *name, int update) {
+    static uint8_t frame[PPM_SIZE];
+    static uint8_t golden[PPM_SIZE];
+    char path[512];
+    char header[32];
+    int header_len = snprintf(header, sizeof(header), "P6\n%d %d\n255\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    snprintf(path, sizeof(path), "%s/%s.ppm", dir, name);
+    framebuffer_to_ppm(frame);
+
+    if (update) {
+        FILE *f = fopen(path, "wb");
+        if (!f) {
+            perror(path);
+            return 0;
+        }
+        fwrite(header, 1, header_len, f);
+        fwrite(frame, 1, PPM_SIZE, f);
+        fclose(f);
+        return 1;
+    }
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return 0;
+    }
+    char file_header[32];
+    int ok = fread(file_header, 1, header_len, f) == (size_t) header_len
+          && memcmp(file_header, header, header_len) == 0
+          && fread(golden, 1, PPM_SIZE, f) == PPM_SIZE;
+    fclose(f);
+    if (!ok) {
+        fprintf(stderr, "%s: not a %dx%d PPM\n", path, SCREEN_WIDTH, SCREEN_HEIGHT);
+        return 0;
+    }
+
+    int diff = 0;
+    for (int i = 0; i < PPM_SIZE; i += 3) {
+        if (memcmp(&frame[i], &golden[i], 3) != 0) {
+            diff++;
+        }
+    }
+    if (diff) {
+        fprintf(stderr, "%s: %d pixels differ from golden frame\n", name, diff);
+    }
+    return diff == 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <golden-dir> [--update]\n", argv[0]);
+        return 2;
+    }
+    const char *golden_dir = argv[1];
+    int update = argc > 2 && strcmp(argv[2], "--update") == 0;
+    int failures = 0;
+
+    initialize_hardware();  // Registers the scheduler tasks
+
+    printf("%-12s %6s %12s %12s %10s %10s %s\n",
+           "screen", "frames", "fb st/frm", "fb B/frm", "io st/frm", "io B/frm", "golden");
+
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        const Scenario *sc = &scenarios[i];
+
+        memset((void *) hal_vga_space, 0, sizeof(hal_vga_space));
+
+        int frames = sc->render();
+        int ok = check_golden(golden_dir, sc->name, update);
+        failures += !ok;
+
+        printf("%-12s %6d %12u %12u %10u %10u %s\n", sc->name, frames,
+               hal_stores.fb.stores / frames, hal_stores.fb.bytes / frames,
+               hal_stores.io.stores / frames, hal_stores.io.bytes / frames,
+               update ? "written" : (ok ? "ok" : "MISMATCH"));
+    }
+
+    return failures ? 1 : 0;
+}
@@ -1,8 +1,19 @@
-// TODO: levels (with ghost hunting you or something)
 // TODO: leaderboard
-// TODO: add speedup switch for multiplayer mode
 
 #include <stdint.h> // For standard integer types
+#include "dtekv-hal.h"
+#include "dtekv-lib.h"
+#include "dtekv-perf.h"
+#include "dtekv-sched.h"
+#include "dtekv-prof.h"
+#include "dtekv-mem.h"
+#include "dtekv-seqlock.h"
+#include "snake-config.h"
+#include "snake-pack.h"
+#include "snake-store.h"
+#include "snake-ghosts.h"
+#include "snake-level.h"
+#include "snake-hud.h"
 
 // --- External Assembly Functions ---
 extern void enable_interrupt(void);
@@ -10,36 +21,25 @@ extern void enable_switch_interrupts(void);
 extern void enable_timer_interrupts(void);
 
 // --- Memory-Mapped I/O Addresses (from DTEK-V PDF) ---
-volatile uint32_t * const TIMER_STATUS = (uint32_t *) 0x4000020;
-volatile uint32_t * const TIMER_CONTROL = (uint32_t *) 0x4000024;
-volatile uint32_t * const TIMER_PERIOD_L = (uint32_t *) 0x4000028;
-volatile uint32_t * const TIMER_PERIOD_H = (uint32_t *) 0x400002C;
+// All stores go through IO_STORE/FB_STORE so host builds can count them
+// The timer's period/control registers are owned by the scheduler (dtekv-sched.c)
+volatile uint32_t * const TIMER_STATUS = IO_REG(0x4000020);
 
-volatile uint32_t * const SWITCHES = (uint32_t *) 0x4000010;
-volatile uint32_t * const BUTTONS = (uint32_t *) 0x40000d0;
+volatile uint32_t * const SWITCHES = IO_REG(0x4000010);
+volatile uint32_t * const BUTTONS = IO_REG(0x40000d0);
 
-// not used yet
-volatile uint32_t * const LEDS = (uint32_t *) 0x4000000;
+// Shows the frame-budget load bar (see watchdog below)
+volatile uint32_t * const LEDS = IO_REG(0x4000000);
 
-volatile uint32_t * const SWITCH_EDGECAPTURE = (uint32_t *) 0x400001C;
-volatile uint32_t * const SWITCH_INTERRUPTMASK = (uint32_t *) 0x4000018;
+volatile uint32_t * const SWITCH_EDGECAPTURE = IO_REG(0x400001C);
+volatile uint32_t * const SWITCH_INTERRUPTMASK = IO_REG(0x4000018);
 
-volatile uint8_t * const VGA_BUFFER = (uint8_t *) 0x8000000;
+volatile uint8_t * const VGA_BUFFER = VGA_MEM(0x8000000);
 
-// --- Screen Dimensions ---
-#define SCREEN_WIDTH 320
-#define SCREEN_HEIGHT 240
+// Screen, cell and grid dimensions live in snake-config.h
 
 // --- Game Object Structures (OOP-style) ---
-typedef struct {
-    int x, y;
-} Point;
-
-typedef struct {
-    Point body[SCREEN_WIDTH * SCREEN_HEIGHT];
-    int length;
-    Point direction; // e.g., {x:1, y:0} for right
-} Snake;
+// Point and the packed body live in snake-pack.h, the snakes in snake-store.h
 
 // --- Random Number Generation (Simple LCG) ---
 static unsigned int random_seed = 1;
@@ -67,32 +67,179 @@ typedef enum {
 // --- Global Game State ---
 GameState current_state = STATE_MENU;
 GameState previous_state = STATE_PLAYING; // Track state changes
-Snake snakes[2];  // Support up to 2 players
-int num_snakes = 1;  // 1 for singleplayer, 2 for multiplayer
+SnakeStore snakes;   // Every snake in play: the human players first, then bots
+int num_players = 1; // Human players: 1 for singleplayer, 2 for multiplayer
 Point food;
-int tick_counter = 0;
+Ghosts ghosts;       // Enemies hunting the snake heads (see snake-ghosts.h)
+int ghost_ticks = 0; // Game steps since the ghosts last moved
+int current_level = 0;  // Index into level_table (see snake-level.h)
+volatile uint32_t level_epoch = 0;  // Bumped whenever the wall layout changes
+uint32_t game_step = 0; // Game steps since the last reset
 int button_pressed_last_frame = 0;
-unsigned int random_timer = 0; // Increments every interrupt for random seed
 
 // --- Menu Selection State ---
 int menu_selection = 0;          // 0 = one player, 1 = two players (toggled by SW0)
-int last_menu_selection = -1;    // Debouncing: track last value to prevent flicker
 int game_mode = 0;               // 0 = singleplayer, 1 = multiplayer
 int losing_player = -1;          // Multiplayer: which player lost (0 or 1), -1 = no clear loser
 
+// --- Level Progression ---
+#define LEVEL_ADVANCE_SCORE 10  // Next level every 10 points (total of all players)
+#define WALL_COLOR 0x92         // Grey
+
+// --- Players ---
+// Snake i starts at spawns[i], START_LENGTH segments long, and is drawn in snake_colors[i]
+#define START_LENGTH 3  // Segments at spawn; score is length - START_LENGTH
+
+typedef struct {
+    Point head;
+    int direction;  // The body trails behind, opposite to it
+} Spawn;
+
+// Spawns sit this far in from the grid edges: an eighth of the grid, but at
+// least START_LENGTH so the body trailing a head that faces away from an edge
+// stays on the grid (snake-config.h rules out grids too small for that)
+#define SPAWN_INSET_X (GRID_WIDTH / 8 > START_LENGTH ? GRID_WIDTH / 8 : START_LENGTH)
+#define SPAWN_INSET_Y (GRID_HEIGHT / 8 > START_LENGTH ? GRID_HEIGHT / 8 : START_LENGTH)
+
+static const Spawn spawns[SNAKES_MAX] = {
+    {{SPAWN_INSET_X, SPAWN_INSET_Y}, SNAKE_DOWN},                              // Top-left
+    {{GRID_WIDTH - SPAWN_INSET_X, GRID_HEIGHT - SPAWN_INSET_Y}, SNAKE_LEFT},   // Bottom-right
+    {{GRID_WIDTH - SPAWN_INSET_X, SPAWN_INSET_Y}, SNAKE_DOWN},                 // Top-right
+    {{SPAWN_INSET_X, GRID_HEIGHT - SPAWN_INSET_Y}, SNAKE_UP},                  // Bottom-left
+    {{GRID_WIDTH / 2, SPAWN_INSET_Y}, SNAKE_DOWN},                             // Top
+    {{GRID_WIDTH / 2, GRID_HEIGHT - SPAWN_INSET_Y}, SNAKE_UP},                 // Bottom
+    {{SPAWN_INSET_X, GRID_HEIGHT / 2}, SNAKE_RIGHT},                           // Left
+    {{GRID_WIDTH - SPAWN_INSET_X, GRID_HEIGHT / 2}, SNAKE_LEFT},               // Right
+};
+
+static const uint8_t snake_colors[SNAKES_MAX] = {
+    0x1F,  // Cyan (player 1)
+    0xE0,  // Red (player 2)
+    0xFC,  // Yellow
+    0xF0,  // Orange
+    0xFF,  // White
+    0x6F,  // Violet
+    0xEE,  // Pink
+    0x0B,  // Blue
+};
+
+#define BOT_SWITCH_SHIFT 6  // SW6-7: bots to add at game start, 2 per step (0-6)
+
+// --- Ghost Tuning ---
+#define GHOST_SCORE_STEP     5   // One more ghost every 5 points
+#define GHOST_STEP_DIV       2   // Ghosts move every 2nd game step (slower than the snake)
+#define GHOST_SPAWN_MIN_DIST 8   // Spawn at least this many cells from the nearest head
+
 // FOR TIMER TESTING
 int test_seconds = 0;
-int test_tick_counter = 0;
+
+// --- Scheduler Tasks (each runs at its own rate, see dtekv-sched.h) ---
+#define STEP_INTERVAL     (SCHED_CPU_HZ / 3)   // 3 moves/sec
+#define STEP_INTERVAL_MIN SCHED_MS(100)        // Fastest step with the speed-up switch
+#define STEP_SPEEDUP      SCHED_MS(5)          // Step shortening per point scored
+#define SPEEDUP_SWITCH    0x20                 // SW5
+#define CLOCK_INTERVAL    SCHED_CPU_HZ         // Singleplayer seconds display
+#define UI_INTERVAL       (SCHED_CPU_HZ / 30)  // Button polling and box animation
+
+int task_step = -1;   // update_game + draw_game while playing
+int task_clock = -1;  // Seconds on displays 4-5 (singleplayer)
+int task_ui = -1;     // Menu and game over screens
+int task_prof = -1;   // PC sampling, only with make PROFILE=1 (see dtekv-prof.h)
+int frame_dirty = 1;  // A game task ran since the last publish_frame()
 
 // test animation for game over box
 // TODO: remove?
 int box_width = 200;  // Current width (starts at full)
 int animating_box = 1;  // Flag to start animation
 
+// --- Published Game State ---
+// The interrupt handler simulates; the main loop draws. Everything the screens
+// need is published as a GameFrame through a seqlock (dtekv-seqlock.h), so the
+// renderer always works on one consistent step and never holds up the handler.
+typedef struct {
+    uint32_t step;           // game_step when published; a new step means a new board
+    GameState state;
+    int num_snakes;
+    int num_players;         // Human players: the first num_players snakes
+    Point heads[SNAKES_MAX];
+    int lengths[SNAKES_MAX];
+    SnakeBody bodies[SNAKES_MAX];
+    Point food;
+    GhostList ghosts;
+    int level_layout;        // level_layouts grid holding this frame's walls
+    uint32_t level_epoch;    // Level loads before this frame was published
+    int losing_player;
+    int menu_selection;
+    int box_width;
+} GameFrame;
+
+_Static_assert(sizeof(GameFrame) % 4 == 0, "GameFrame is copied in whole words");
+
+GameFrame frames[2];   // Written only by publish_frame()
+SeqLock frame_lock;
+GameFrame view;        // Main loop's private copy of the latest frame
+
+// What is on screen now, so present() only redraws what changed
+int shown_state = -1;  // -1 = nothing yet, draw the whole screen
+uint32_t shown_step = 0;
+int shown_selection = 0;
+int shown_box_width = 0;
+
+// --- Camera ---
+// The screen shows VIEW_WIDTH x VIEW_HEIGHT cells of the world starting at
+// camera, which follows player 1 once their head gets within CAMERA_MARGIN
+// cells of the edge. Boards are drawn by rasterising the visible cells into
+// board_cells and only repainting cells that differ from shown_cells, so a
+// frame costs the same however large the world is, and a camera move only
+// repaints the cells whose colour actually changed.
+#define CAMERA_MARGIN_X (VIEW_WIDTH / 4)
+#define CAMERA_MARGIN_Y (VIEW_HEIGHT / 4)
+
+Point camera = {0, 0};               // World cell at the top-left of the screen
+uint8_t board_cells[VIEW_CELLS];     // Colour of each visible cell this frame
+uint8_t shown_cells[VIEW_CELLS];     // Colour of each cell on screen now
+
+// --- Frame-Budget Watchdog ---
+// Tracks how much time the timer handler takes and whether it runs into the next deadline
+#define WD_LOAD_WINDOW (SCHED_CPU_HZ / 4)   // Load is averaged over 250 ms
+
+unsigned int wd_last_cycles = 0;    // Duration of the most recent timer handler
+unsigned int wd_max_cycles = 0;     // Longest timer handler seen so far
+unsigned int wd_avg_cycles = 0;     // Mean timer handler over the last load window
+unsigned int wd_load_percent = 0;   // Share of the last load window spent in the handler
+unsigned int wd_overruns = 0;       // Handlers that ran past the next deadline
+unsigned int wd_dropped_base = 0;   // sched_missed_runs() at the last reset
+int wd_last_slack = 0;              // Cycles left before the next deadline on exit
+uint32_t wd_busy_cycles = 0;        // Handler time in the current load window
+uint32_t wd_window_runs = 0;        // Handlers in the current load window
+uint32_t wd_window_start = 0;
+uint32_t wd_led_bar = 0;            // Last pattern written to the LEDs
+
+// --- Metrics Overlay ---
+// With make HUD=1, SW4 shows fps, interrupt handler cycles (average and
+// maximum over every cause),
+// dropped ticks and snake lengths in the top-left corner (see snake-hud.h).
+// The main loop refreshes the numbers a few times a second and repaints only
+// the digits that changed.
+#ifdef HUD_ENABLE
+#define HUD_SWITCH   0x10                 // SW4
+#define HUD_INTERVAL (SCHED_CPU_HZ / 4)   // Numbers refresh every 250 ms
+
+int hud_on = 0;
+int hud_shrunk = 0;               // Panel uncovered screen it no longer paints
+uint32_t hud_frames = 0;          // Frames drawn since hud_window_start
+uint32_t hud_window_start = 0;
+uint32_t irq_max_cycles = 0;      // Longest handle_interrupt() call, any cause
+uint32_t irq_avg_cycles = 0;      // Mean handle_interrupt() call over the last HUD_INTERVAL
+uint32_t irq_busy_cycles = 0;     // Handler time in the current window
+uint32_t irq_window_runs = 0;     // Handler calls in the current window
+uint32_t irq_window_start = 0;
+#endif
+
 // --- 7-Segment Display Functions ---
 // task e - from oldlabinterrupts.c
 void set_displays(int display_number, int value) {
-    *((volatile int *)0x04000050 + (display_number * 4)) = value;
+    IO_STORE(IO_REG(0x04000050) + (display_number * 4), value);
 }
 
 // --- Function Prototypes ---
@@ -102,21 +249,45 @@ void update_game(void);
 void read_input(void);
 void check_button_input(void);
 void clear_screen(uint8_t color);
-void draw_menu(void);
-void draw_game(void);
-void draw_game_over(void);
-void draw_game_over_animated(void);  // test animation: draw only the animated box
+void draw_menu(const GameFrame *f);
+void draw_game(const GameFrame *f);
+void draw_board(const GameFrame *f);
+void update_camera(Point target);
+void draw_game_over(const GameFrame *f);
+void draw_game_over_animated(const GameFrame *f);  // test animation: draw only the animated box
 void draw_pixel(int x, int y, uint8_t color);
 void draw_rect(int x, int y, int width, int height, uint8_t color);
+void draw_cell_run(Point cell, int count, uint8_t color);
 void set_displays(int display_number, int value);
 void display_score_single(int score);
 void display_score_multi(int score1, int score2);
+void enter_state(void);
+void publish_frame(void);
+void read_frame(GameFrame *frame);
+void present(void);
+void step_task(void);
+void clock_task(void);
+void ui_task(void);
+uint32_t step_interval(void);
+void watchdog_end(uint32_t start_cycles, int32_t slack);
+int watchdog_report(int piece);
+int frame_report(int piece);
+void poll_uart_commands(void);
+void hud_update(int redrawn);
+void irq_cost_end(uint32_t start_cycles);
 
 // --- Helper Functions for Game Logic ---
 int check_wall_collision(Point p);
-int check_snake_collision(Point p, Snake* s);
-void move_snake(Snake* s);
-void update_snake_direction(Snake* s, uint32_t sw_bits);
+int check_any_snake(Point p);
+int human_score(void);
+int rival_player(int i);
+void respawn_bot(int i);
+void update_ghosts(void);
+void spawn_ghosts(void);
+void load_level(int level);
+void steer_snakes(void);
+int bot_direction(int i);
+void update_snake_direction(int i, uint32_t sw_bits);
 
 // --- Letter Drawing Functions (20x30 px each, data-driven) ---
 void draw_letter(char letter, int x, int y, uint8_t color);
@@ -141,94 +312,55 @@ const int segment_map[10] = {
  * Routes timer and switch interrupts based on current game state.
  */
 void handle_interrupt(unsigned cause) {
+#ifdef HUD_ENABLE
+    uint32_t irq_start = perf_read_cycles();
+#endif
+    perf_irq_enter();  // Keeps handler time out of the main loop's render region
+
     if (cause == 16) { // Timer interrupt
-        *TIMER_STATUS = 0;
-        random_timer++; // Always increment for random seed entropy
-        
-        // Draw static screens only when state changes (prevents flickering)
+        uint32_t start_cycles = perf_read_cycles();
+        IO_STORE(TIMER_STATUS, 0);
+
+        // Run whichever tasks are due (game step, clock, menu/game over)
+        sched_dispatch();
+
+        // Swap task sets only when state changes
         if (current_state != previous_state) {
-            if (current_state == STATE_MENU) {
-                last_menu_selection = -1;  // Reset to force initial draw
-                draw_menu();
-            } else if (current_state == STATE_GAME_OVER) {
-                box_width = 200;  // Reset animation on state entry
-                animating_box = 1;
-                draw_game_over();  // Initial full draw
-            }
-            previous_state = current_state;
+            enter_state();
         }
-        
-        // State machine: different behavior depending on the state
-        switch (current_state) {
-            case STATE_MENU:
-                check_button_input();
-                break;
-                
-            case STATE_PLAYING:
-                tick_counter++;
-                int speed = 10;  // Game speed (10 interrupts per move at 30Hz = 3 moves/sec)
-
-                if (tick_counter >= speed) {
-                    tick_counter = 0; // update game every speed interrupts
-                    update_game();
-                    draw_game();
-                }
-                
-                // Timer only for singleplayer mode (displays 4-5)
-                if (num_snakes == 1) {
-                    test_tick_counter++;
-                    if (test_tick_counter >= 30) {  // 30 interrupts = 1 second at 30Hz
-                        test_tick_counter = 0;
-                        test_seconds++;
-                        if (test_seconds >= 60) {
-                            test_seconds = 0;
-                        }
-                        // Update displays 4-5 with current seconds
-                        int tens = (test_seconds / 10) % 10;
-                        int ones = test_seconds % 10;
-                        set_displays(4, segment_map[ones]);
-                        set_displays(5, segment_map[tens]);
-                    }
-                }
-                break;
-                
-            case STATE_GAME_OVER:
-                check_button_input();
-
-                // for test box animation
-                if (animating_box && box_width > 0) {
-                    box_width -= 1;  // Shrink by 1 pixel per frame (adjust for speed)
-                    if (box_width <= 0) {
-                        box_width = 0;
-                        animating_box = 0;  // Stop animation when it hits 0
-                    }
-                    // Update only the animated box
-                    draw_game_over_animated();
-                }
-
-                break;
+        // Profiler-only ticks change nothing on screen, so skip the copy
+        if (frame_dirty) {
+            publish_frame();
         }
+
+        watchdog_end(start_cycles, sched_arm());
     } 
     else if (cause == 17) { // Switch interrupt
-        *SWITCH_EDGECAPTURE = 0x3FF;
+        IO_STORE(SWITCH_EDGECAPTURE, 0x3FF);
         
         // State-specific switch handling
         if (current_state == STATE_PLAYING) {
             // Gameplay: SW0 and SW1 control direction
+            perf_begin(PERF_INPUT);
             read_input();
+            perf_end(PERF_INPUT);
         } 
         else if (current_state == STATE_MENU) {
             // Menu: SW0 toggles difficulty selection
             int new_selection = (*SWITCHES & 0x1) ? 1 : 0;
             
-            // Only redraw if selection actually changed (to stop flickering)
-            if (new_selection != last_menu_selection) {
+            // Only publish if selection actually changed; the main loop redraws
+            if (new_selection != menu_selection) {
                 menu_selection = new_selection;
-                last_menu_selection = new_selection;
-                draw_menu();
+                publish_frame();
             }
         }
     }
+
+#ifdef HUD_ENABLE
+    irq_cost_end(irq_start);
+#endif
+    perf_irq_exit();
 }
 
 
@@ -238,31 +370,230 @@ void handle_interrupt(unsigned cause) {
 int main(void) {
     initialize_hardware();
     
-    // Start in menu state, show menu immediately
+    // Start in menu state; the first present() shows it
     current_state = STATE_MENU;
-    draw_menu();
+    enter_state();
+    publish_frame();
+
+    // Arm the timer for the first deadline, then let interrupts in
+    sched_arm();
+    enable_interrupt();
     
     while (1) {
-        // Everything handled by interrupts
+        // Game logic runs in interrupts; drawing and diagnostics run here
+        present();
+        poll_uart_commands();
     }
     return 0;
 }
 
+/**
+ * @brief Runs state-entry work: enables the scheduler tasks the new state
+ * needs (and only those, so e.g. the menu's 30 Hz button polling does not
+ * keep waking the CPU during gameplay). present() notices the new state in
+ * the next published frame and draws the whole screen.
+ */
+void enter_state(void) {
+    int playing = (current_state == STATE_PLAYING);
+
+    sched_set_period(task_step, step_interval());
+    sched_enable(task_step, playing);
+    sched_enable(task_clock, playing && num_players == 1);  // Timer only for singleplayer
+    sched_enable(task_ui, !playing);
+
+    if (current_state == STATE_GAME_OVER) {
+        box_width = 200;  // Reset animation on state entry
+        animating_box = 1;
+    }
+    previous_state = current_state;
+    frame_dirty = 1;
+}
+
+/**
+ * @brief Time between game steps. With the speed-up switch (SW5) on, every
+ * point scored (by either player) shortens the step by STEP_SPEEDUP.
+ */
+uint32_t step_interval(void) {
+    if (!(*SWITCHES & SPEEDUP_SWITCH)) {
+        return STEP_INTERVAL;
+    }
+    uint32_t speedup = human_score() * STEP_SPEEDUP;
+    if (speedup > STEP_INTERVAL - STEP_INTERVAL_MIN) {
+        return STEP_INTERVAL_MIN;
+    }
+    return STEP_INTERVAL - speedup;
+}
+
+/**
+ * @brief Game step task: moves the snakes. The board is redrawn by present()
+ * once the handler publishes the step.
+ */
+void step_task(void) {
+    perf_begin(PERF_LOGIC);
+    update_game();
+    perf_end(PERF_LOGIC);
+    game_step++;
+
+    sched_set_period(task_step, step_interval());
+    frame_dirty = 1;
+}
+
+/**
+ * @brief Clock task: counts seconds on displays 4-5 in singleplayer.
+ */
+void clock_task(void) {
+    test_seconds++;
+    if (test_seconds >= 60) {
+        test_seconds = 0;
+    }
+    // Update displays 4-5 with current seconds
+    int tens = (test_seconds / 10) % 10;
+    int ones = test_seconds % 10;
+    set_displays(4, segment_map[ones]);
+    set_displays(5, segment_map[tens]);
+}
+
+/**
+ * @brief UI task for the menu and game over screens: polls the button and
+ * runs the game over box animation.
+ */
+void ui_task(void) {
+    perf_begin(PERF_INPUT);
+    check_button_input();
+    perf_end(PERF_INPUT);
+    frame_dirty = 1;
+
+    // for test box animation
+    if (current_state == STATE_GAME_OVER && animating_box && box_width > 0) {
+        box_width -= 1;  // Shrink by 1 pixel per frame (adjust for speed)
+        if (box_width <= 0) {
+            box_width = 0;
+            animating_box = 0;  // Stop animation when it hits 0
+        }
+    }
+}
+
+/**
+ * @brief Publishes the current game state as the latest GameFrame.
+ * Called from the interrupt handler after the tasks have run.
+ */
+void publish_frame(void) {
+    GameFrame *f = &frames[seqlock_write_begin(&frame_lock)];
+
+    f->step = game_step;
+    f->state = current_state;
+    f->num_snakes = snakes.count;
+    f->num_players = num_players;
+    for (int i = 0; i < snakes.count; i++) {
+        f->heads[i] = snakes.head[i];
+        f->lengths[i] = snakes.length[i];
+        seqlock_copy(&f->bodies[i], &snakes.body[i], sizeof(SnakeBody));
+    }
+    f->food = food;
+    seqlock_copy(&f->ghosts, &ghosts.list, sizeof(GhostList));
+    f->level_layout = level_active;
+    f->level_epoch = level_epoch;
+    f->losing_player = losing_player;
+    f->menu_selection = menu_selection;
+    f->box_width = box_width;
+
+    seqlock_write_end(&frame_lock);
+    frame_dirty = 0;
+}
+
+/**
+ * @brief Copies the latest published GameFrame, retrying if the handler
+ * published twice while it was being copied.
+ */
+void read_frame(GameFrame *frame) {
+    uint32_t seq;
+    do {
+        seq = seqlock_read_begin(&frame_lock);
+        seqlock_copy(frame, &frames[seqlock_read_slot(seq)], sizeof(GameFrame));
+    } while (seqlock_read_retry(&frame_lock, seq));
+}
+
+/**
+ * @brief Brings the screen up to date with the latest published frame:
+ * the whole screen on a state change, otherwise only what the state redraws
+ * (the menu on a new selection, the board on a new step, the game over box
+ * as it shrinks). Returns at once if nothing was published since last time.
+ */
+void present(void) {
+    static uint32_t presented_seq = 1;  // Odd, so never equal to a published seq
+#ifdef HUD_ENABLE
+    int hud_wanted = (*SWITCHES & HUD_SWITCH) != 0;
+    if (hud_wanted != hud_on || hud_shrunk) {
+        hud_on = hud_wanted;
+        hud_shrunk = 0;
+        shown_state = -1;  // Draw the whole screen, with or without the panel
+    }
+#endif
+    uint32_t seq = seqlock_read_begin(&frame_lock);
+    if (seq == presented_seq && shown_state >= 0) {
+        return;
+    }
+    presented_seq = seq;
+    read_frame(&view);
+
+    perf_begin(PERF_RENDER);
+    int redrawn = 1;  // Drew over the screen other than cell by cell
+    if ((int) view.state != shown_state) {
+        if (view.state == STATE_MENU) {
+            draw_menu(&view);
+        } else if (view.state == STATE_PLAYING) {
+            draw_game(&view);
+        } else {
+            draw_game_over(&view);
+        }
+    } else if (view.state == STATE_MENU && view.menu_selection != shown_selection) {
+        draw_menu(&view);
+    } else if (view.state == STATE_PLAYING && view.step != shown_step) {
+        draw_board(&view);
+        redrawn = 0;
+    } else if (view.state == STATE_GAME_OVER && view.box_width != shown_box_width) {
+        draw_game_over_animated(&view);
+    } else {
+        redrawn = -1;  // Nothing new to draw
+    }
+    hud_update(redrawn);
+    perf_end(PERF_RENDER);
+
+    shown_state = view.state;
+    shown_step = view.step;
+    shown_selection = view.menu_selection;
+    shown_box_width = view.box_width;
+
+    // The frame names the wall grid it was published with, and a level load
+    // only ever writes the other one. That grid is reused by the load after
+    // next, LEVEL_ADVANCE_SCORE points later, so it can only have changed
+    // under this pass if the main loop stalled for that long; if it did,
+    // the board is drawn again from the next frame
+    if (level_epoch - view.level_epoch >= 2) {
+        shown_step--;
+        presented_seq = 1;
+    }
+}
+
 /**
  * @brief Sets up hardware: timer, interrupts, and peripherals.
  */
 void initialize_hardware(void) {
-    // Set up a timer to interrupt 30 times per second (30Hz)
-    *TIMER_PERIOD_H = 0x000F;
-    *TIMER_PERIOD_L = 0x423F;
-    *TIMER_CONTROL = 0x7;
+    // Timer tasks; enter_state() enables the ones each state needs.
+    // The timer is programmed per deadline by sched_arm().
+    task_step = sched_add(step_task, STEP_INTERVAL);
+    task_clock = sched_add(clock_task, CLOCK_INTERVAL);
+    task_ui = sched_add(ui_task, UI_INTERVAL);
+#ifdef PROFILE_PC
+    task_prof = sched_add(prof_task, PROF_INTERVAL);
+    sched_enable(task_prof, 1);  // Samples in every state
+#endif
     
     // Initially enable only SW0 for menu navigation
-    *SWITCH_INTERRUPTMASK = 0x1;
+    IO_STORE(SWITCH_INTERRUPTMASK, 0x1);
     
     enable_switch_interrupts();
     enable_timer_interrupts();
-    enable_interrupt();
 }
 
 /**
@@ -270,46 +601,45 @@ void initialize_hardware(void) {
  */
 void reset_game(void) {
     // Configure switch interrupts based on game mode
-    if (num_snakes == 1) {
+    if (num_players == 1) {
         // Singleplayer: Enable SW0-1 (bits 0-1)
-        *SWITCH_INTERRUPTMASK = 0x3;
+        IO_STORE(SWITCH_INTERRUPTMASK, 0x3);
     } else {
         // Multiplayer: Enable SW0-1 and SW8-9 (bits 0-1, 8-9)
-        *SWITCH_INTERRUPTMASK = 0x303;
+        IO_STORE(SWITCH_INTERRUPTMASK, 0x303);
     }
     
-    // Initialize player 1 snake (top-left)
-    snakes[0].length = 3;
-    snakes[0].body[0] = (Point){40, 30};
-    snakes[0].body[1] = (Point){40, 20};
-    snakes[0].body[2] = (Point){40, 10};
-    snakes[0].direction = (Point){0, 10};  // Moving down
-    
-    // Initialize player 2 snake (bottom-right) if multiplayer
-    if (num_snakes == 2) {
-        snakes[1].length = 3;
-        snakes[1].body[0] = (Point){280, 210};
-        snakes[1].body[1] = (Point){290, 210};
-        snakes[1].body[2] = (Point){300, 210};
-        snakes[1].direction = (Point){-10, 0};  // Moving left
+    // Human players first (player 1 top-left, player 2 bottom-right),
+    // then the bots asked for on SW6-7 in the remaining spawn slots
+    store_clear(&snakes);
+    int bots = ((*SWITCHES >> BOT_SWITCH_SHIFT) & 0x3) * 2;
+    for (int i = 0; i < num_players + bots && i < SNAKES_MAX; i++) {
+        store_add(&snakes, spawns[i].head, START_LENGTH, spawns[i].direction,
+                  i < num_players ? PLAYER_HUMAN : PLAYER_BOT);
     }
 
     // Initialize score display
-    if (num_snakes == 1) {
-        display_score_single(snakes[0].length - 3);
+    if (num_players == 1) {
+        display_score_single(snakes.length[0] - START_LENGTH);
     } else {
-        display_score_multi(snakes[0].length - 3, snakes[1].length - 3);
+        display_score_multi(snakes.length[0] - START_LENGTH, snakes.length[1] - START_LENGTH);
     }
 
     // Place food at random position
-    food.x = random_int(0, 31) * 10;
-    food.y = random_int(0, 23) * 10;
+    food.x = random_int(0, GRID_WIDTH - 1);
+    food.y = random_int(0, GRID_HEIGHT - 1);
+
+    // Every game starts on the open level
+    load_level(0);
+
+    // No ghosts until the first points are scored
+    ghosts_reset(&ghosts);
+    field_reset();
+    ghost_ticks = 0;
 
-    tick_counter = 0;
-    
     // Reset timer for singleplayer
     test_seconds = 0;
-    test_tick_counter = 0;
+    game_step = 0;
     
     // Reset losing player for multiplayer
     losing_player = -1;
@@ -326,10 +656,10 @@ void check_button_input(void) {
         if (current_state == STATE_MENU) {
             // Store selected game mode (0=single, 1=multi)
             game_mode = menu_selection;
-            num_snakes = (game_mode == 0) ? 1 : 2;
+            num_players = (game_mode == 0) ? 1 : 2;
             
-            // Seed with timer value - different each time button is pressed
-            seed_random(random_timer);
+            // Seed with the cycle counter - different each time button is pressed
+            seed_random(perf_read_cycles());
             reset_game();
             current_state = STATE_PLAYING;
         }
@@ -350,86 +680,128 @@ void read_input(void) {
     uint32_t switches = *SWITCHES;
     
     // Player 1: SW0-1 (bits 0-1)
-    update_snake_direction(&snakes[0], switches & 0b11);
+    update_snake_direction(0, switches & 0b11);
     
     // Player 2: SW8-9 (bits 8-9) if multiplayer
-    if (num_snakes == 2) {
-        update_snake_direction(&snakes[1], (switches >> 8) & 0b11);
+    if (num_players == 2) {
+        update_snake_direction(1, (switches >> 8) & 0b11);
     }
 }
 
 
 /**
  * @brief Updates snake position, checks for collisions and food.
+ * Every check is a grid lookup per snake, so a step costs the same per
+ * snake however many are playing.
  */
 void update_game(void) {
+    // Bots and replays pick their moves; humans already did via the switches
+    steer_snakes();
+
     // Calculate new head positions for all snakes (for collision checking)
-    Point new_heads[2];
-    for (int i = 0; i < num_snakes; i++) {
-        new_heads[i].x = snakes[i].body[0].x + snakes[i].direction.x;
-        new_heads[i].y = snakes[i].body[0].y + snakes[i].direction.y;
+    Point new_heads[SNAKES_MAX];
+    for (int i = 0; i < snakes.count; i++) {
+        new_heads[i].x = snakes.head[i].x + SNAKE_DX[snakes.dir[i]];
+        new_heads[i].y = snakes.head[i].y + SNAKE_DY[snakes.dir[i]];
     }
     
-    // Check head-to-head collision first (multiplayer only)
-    if (num_snakes == 2) {
-        if (new_heads[0].x == new_heads[1].x && new_heads[0].y == new_heads[1].y) {
-            // Both snakes moving to same position - use points to determine winner
+    // Only the human players' crashes end the game; a bot that crashes does
+    // not move this step and is sent back to a spawn point afterwards
+    uint8_t crashed[SNAKES_MAX] = {0};
+
+    // Check head-to-head collisions first (two snakes moving to the same cell)
+    int j;
+    while ((j = store_find_head_on(&snakes, new_heads)) >= 0) {
+        int other = 0;  // The snake that claimed the cell first
+        while (new_heads[other].x != new_heads[j].x || new_heads[other].y != new_heads[j].y) {
+            other++;
+        }
+        int bot = (snakes.kind[j] != PLAYER_HUMAN) ? j : (snakes.kind[other] != PLAYER_HUMAN) ? other : -1;
+        if (bot < 0) {
+            // No clear loser - use points to determine winner
             losing_player = -1;
             current_state = STATE_GAME_OVER;
             return;
         }
+        crashed[bot] = 1;
+        new_heads[bot] = (Point){-1, -1};  // Off the grid: out of the head-on check
     }
-    
-    // Check collisions for all snakes BEFORE moving them
-    for (int i = 0; i < num_snakes; i++) {
-        // Check wall collision - this player loses
-        if (check_wall_collision(new_heads[i])) {
-            losing_player = (num_snakes == 2) ? i : -1;
-            current_state = STATE_GAME_OVER;
-            return;
+
+    // Check collisions for all snakes BEFORE moving them; whoever crashes loses
+    for (int i = 0; i < snakes.count; i++) {
+        if (crashed[i]) {
+            continue;
         }
-        
-        // Check self-collision - this player loses
-        if (check_snake_collision(new_heads[i], &snakes[i])) {
-            losing_player = (num_snakes == 2) ? i : -1;
+
+        // Walls, ghosts, or any snake, itself included. Tails count as
+        // occupied even though they are about to move on.
+        if (check_wall_collision(new_heads[i]) || ghosts_at(&ghosts, new_heads[i])
+            || store_owner(&snakes, new_heads[i]) >= 0) {
+            if (snakes.kind[i] != PLAYER_HUMAN) {
+                crashed[i] = 1;
+                continue;
+            }
+            losing_player = (num_players > 1) ? i : -1;
             current_state = STATE_GAME_OVER;
             return;
         }
-        
-        // Check head-to-body collision with other snake (multiplayer only)
-        if (num_snakes == 2) {
-            int other = 1 - i;  // Other snake index
-            // Start from j=1 to skip the other snake's head (already checked above)
-            for (int j = 1; j < snakes[other].length; j++) {
-                if (new_heads[i].x == snakes[other].body[j].x && 
-                    new_heads[i].y == snakes[other].body[j].y) {
-                    // Head-to-body collision - this player (i) loses
-                    losing_player = i;
-                    current_state = STATE_GAME_OVER;
-                    return;
-                }
-            }
-        }
     }
     
-    // All moves are safe - update all snakes
-    for (int i = 0; i < num_snakes; i++) {
-        move_snake(&snakes[i]);
+    // All remaining moves are safe - update those snakes
+    for (int i = 0; i < snakes.count; i++) {
+        if (!crashed[i]) {
+            store_push(&snakes, i, snakes.dir[i]);
+        }
+    }
+    for (int i = 0; i < snakes.count; i++) {
+        if (crashed[i]) {
+            respawn_bot(i);
+        }
+    }
+
+    // Ghosts chase the new heads; one catching a player's head ends the game
+    update_ghosts();
+    for (int i = 0; i < snakes.count; i++) {
+        if (ghosts_at(&ghosts, snakes.head[i])) {
+            if (snakes.kind[i] != PLAYER_HUMAN) {
+                respawn_bot(i);
+                continue;
+            }
+            losing_player = (num_players > 1) ? i : -1;
+            current_state = STATE_GAME_OVER;
+            return;
+        }
     }
     
     // Check food collision for all snakes
-    for (int i = 0; i < num_snakes; i++) {
-        if (snakes[i].body[0].x == food.x && snakes[i].body[0].y == food.y) {
-            // Grow snake
-            Point old_tail_pos = snakes[i].body[snakes[i].length - 1];
-            snakes[i].length++;
-            snakes[i].body[snakes[i].length - 1] = old_tail_pos;
+    for (int i = 0; i < snakes.count; i++) {
+        if (snakes.head[i].x == food.x && snakes.head[i].y == food.y) {
+            // Grow snake: keep the tail segment the move just left behind
+            store_grow(&snakes, i);
+
+            // Every LEVEL_ADVANCE_SCORE points moves on to the next layout
+            int level = (human_score() / LEVEL_ADVANCE_SCORE) % level_count;
+            if (level != current_level) {
+                load_level(level);
+            }
             
             // Update score display
-            if (num_snakes == 1) {
-                display_score_single(snakes[0].length - 3);
+            if (num_players == 1) {
+                display_score_single(snakes.length[0] - START_LENGTH);
             } else {
-                display_score_multi(snakes[0].length - 3, snakes[1].length - 3);
+                display_score_multi(snakes.length[0] - START_LENGTH, snakes.length[1] - START_LENGTH);
+            }
+
+            // A snake as long as its ring can hold cannot grow any further:
+            // a player there has won, a bot starts over
+            if (snakes.length[i] >= SNAKE_LENGTH_MAX) {
+                if (snakes.kind[i] != PLAYER_HUMAN) {
+                    respawn_bot(i);
+                } else {
+                    losing_player = rival_player(i);
+                    current_state = STATE_GAME_OVER;
+                    return;
+                }
             }
             
             // Relocate food to new random position
@@ -437,22 +809,16 @@ void update_game(void) {
             const int MAX_ATTEMPTS = 100;
             
             do {
-                food.x = random_int(0, 31) * 10;
-                food.y = random_int(0, 23) * 10;
+                food.x = random_int(0, GRID_WIDTH - 1);
+                food.y = random_int(0, GRID_HEIGHT - 1);
                 attempts++;
                 
-                // Check if food position conflicts with any snake body
-                int collision = 0;
-                for (int s = 0; s < num_snakes && !collision; s++) {
-                    for (int j = 0; j < snakes[s].length && !collision; j++) {
-                        if (food.x == snakes[s].body[j].x && food.y == snakes[s].body[j].y) {
-                            collision = 1;
-                        }
-                    }
-                }
-                
-                if (!collision) break;
+                // Check if food position conflicts with a wall or any snake body
+                if (!level_is_wall(food) && !check_any_snake(food)) break;
             } while (attempts < MAX_ATTEMPTS);
+
+            // Every GHOST_SCORE_STEP points brings another ghost
+            spawn_ghosts();
             
             break;  // Only one snake can eat per frame
         }
@@ -464,7 +830,7 @@ void update_game(void) {
  */
 void clear_screen(uint8_t color) {
     for (int i = 0; i < SCREEN_WIDTH * SCREEN_HEIGHT; i++) {
-        VGA_BUFFER[i] = color;
+        FB_STORE(&VGA_BUFFER[i], color);
     }
 }
 
@@ -472,7 +838,7 @@ void clear_screen(uint8_t color) {
  * @brief Draws the menu screen.
  * Edit this function to customize the menu appearance.
  */
-void draw_menu(void) {
+void draw_menu(const GameFrame *f) {
     clear_screen(0x03); // Dark blue background
     
     draw_letter('S', 80, 40, 0x1C);
@@ -506,7 +872,7 @@ void draw_menu(void) {
 
     // --- Game Mode Selection (SW0 toggles) ---
     // ONE P - highlighted if menu_selection == 0
-    uint8_t one_p_color = (menu_selection == 0) ? 0x1D : 0x24;  // Bright green if selected, dim if not
+    uint8_t one_p_color = (f->menu_selection == 0) ? 0x1D : 0x24;  // Bright green if selected, dim if not
     draw_letter('O', 215, 90, one_p_color);
     draw_letter('N', 240, 90, one_p_color);
     draw_letter('E', 265, 90, one_p_color);
@@ -514,7 +880,7 @@ void draw_menu(void) {
     draw_letter('P', 295, 90, one_p_color);
     
     // TWO P - highlighted if menu_selection == 1
-    uint8_t two_p_color = (menu_selection == 1) ? 0xE1 : 0x24;  // Bright red if selected, dim if not
+    uint8_t two_p_color = (f->menu_selection == 1) ? 0xE1 : 0x24;  // Bright red if selected, dim if not
     draw_letter('T', 215, 130, two_p_color);
     draw_letter('W', 240, 130, two_p_color);
     draw_letter('O', 265, 130, two_p_color);
@@ -537,35 +903,123 @@ void draw_menu(void) {
 }
 
 /**
- * @brief Draws the gameplay screen.
+ * @brief Draws the gameplay screen from scratch.
  */
-void draw_game(void) {
+void draw_game(const GameFrame *f) {
     clear_screen(0x00); // Black background
-    
-    // Draw player 1 snake (cyan/blue)
-    for (int i = 0; i < snakes[0].length; i++) {
-        draw_rect(snakes[0].body[i].x, snakes[0].body[i].y, 10, 10, 0x1F);
+    for (int i = 0; i < VIEW_CELLS; i++) {
+        shown_cells[i] = 0x00;
+    }
+    draw_board(f);
+}
+
+/**
+ * @brief Sets a visible cell of the board raster; cells off screen are culled.
+ * @param p World position of the cell
+ */
+static inline void raster_cell(Point p, uint8_t color) {
+    uint32_t x = p.x - camera.x;
+    uint32_t y = p.y - camera.y;
+    if (x < VIEW_WIDTH && y < VIEW_HEIGHT) {
+        board_cells[y * VIEW_WIDTH + x] = color;
+    }
+}
+
+/**
+ * @brief Brings the board on screen up to date with frame f.
+ * Rasterises the visible cells (walls, then snakes, food and ghosts on
+ * top) and repaints only the cells whose colour changed.
+ */
+void draw_board(const GameFrame *f) {
+    update_camera(f->heads[0]);
+
+    // Walls and floor, from the collision grid the frame was published with
+    const LevelWalls *walls = &level_layouts[f->level_layout];
+    for (int y = 0; y < VIEW_HEIGHT; y++) {
+        for (int x = 0; x < VIEW_WIDTH; x++) {
+            Point p = {camera.x + x, camera.y + y};
+            board_cells[y * VIEW_WIDTH + x] = level_wall_in(walls, p) ? WALL_COLOR : 0x00;
+        }
     }
     
-    // Draw player 2 snake (red) if multiplayer
-    if (num_snakes == 2) {
-        for (int i = 0; i < snakes[1].length; i++) {
-            draw_rect(snakes[1].body[i].x, snakes[1].body[i].y, 10, 10, 0xE0);
+    // Snakes (player 1 cyan, player 2 red, bots see snake_colors)
+    for (int i = 0; i < f->num_snakes; i++) {
+        for (SnakeIter it = snake_iter(&f->bodies[i], f->heads[i], f->lengths[i]); snake_iter_valid(&it); snake_iter_next(&it)) {
+            raster_cell(it.pos, snake_colors[i]);
         }
     }
     
-    // Draw food
-    draw_rect(food.x, food.y, 10, 10, 0x1C); // Green
+    // Food
+    raster_cell(f->food, 0x1C); // Green
+
+    // Ghosts on top (magenta)
+    for (int i = 0; i < f->ghosts.count; i++) {
+        raster_cell(f->ghosts.pos[i], 0xE3);
+    }
+
+    // Repaint what changed, filling each horizontal run of changed cells of
+    // one colour (wall segments, floor, a full redraw's rows) as a single span
+    for (int y = 0; y < VIEW_HEIGHT; y++) {
+        int x = 0;
+        while (x < VIEW_WIDTH) {
+            int i = y * VIEW_WIDTH + x;
+            if (board_cells[i] == shown_cells[i]) {
+                x++;
+                continue;
+            }
+            uint8_t color = board_cells[i];
+            int count = 0;
+            while (x + count < VIEW_WIDTH && board_cells[i + count] == color
+                   && shown_cells[i + count] != color) {
+                shown_cells[i + count] = color;
+                count++;
+            }
+            draw_cell_run((Point){x, y}, count, color);
+            x += count;
+        }
+    }
+}
+
+/**
+ * @brief Moves the camera just enough to keep target CAMERA_MARGIN cells
+ * away from the screen edges, without looking past the edge of the world.
+ * @param target World position to follow
+ */
+void update_camera(Point target) {
+    if (target.x < camera.x + CAMERA_MARGIN_X) {
+        camera.x = target.x - CAMERA_MARGIN_X;
+    } else if (target.x >= camera.x + VIEW_WIDTH - CAMERA_MARGIN_X) {
+        camera.x = target.x - VIEW_WIDTH + CAMERA_MARGIN_X + 1;
+    }
+    if (target.y < camera.y + CAMERA_MARGIN_Y) {
+        camera.y = target.y - CAMERA_MARGIN_Y;
+    } else if (target.y >= camera.y + VIEW_HEIGHT - CAMERA_MARGIN_Y) {
+        camera.y = target.y - VIEW_HEIGHT + CAMERA_MARGIN_Y + 1;
+    }
+
+    // Clamp to the world; a one-screen world keeps the camera at 0,0
+    if (camera.x > GRID_WIDTH - VIEW_WIDTH) {
+        camera.x = GRID_WIDTH - VIEW_WIDTH;
+    }
+    if (camera.x < 0) {
+        camera.x = 0;
+    }
+    if (camera.y > GRID_HEIGHT - VIEW_HEIGHT) {
+        camera.y = GRID_HEIGHT - VIEW_HEIGHT;
+    }
+    if (camera.y < 0) {
+        camera.y = 0;
+    }
 }
 
 /**
  * @brief Draws the game over screen.
  * Edit this function to customize the game over appearance.
  */
-void draw_game_over(void) {
+void draw_game_over(const GameFrame *f) {
     clear_screen(0x00); // black background
 
-    draw_rect(35, 75, 200, 5, 0xE0);  // Initial full width
+    draw_rect(35, 75, f->box_width, 5, 0xE0);  // Full width on state entry
 
     // title
     draw_letter('G', 35, 40, 0xE0);
@@ -582,20 +1036,28 @@ void draw_game_over(void) {
     draw_rect(248, 67, 3, 3, 0xE0); // red box
 
     // Score display
-    if (num_snakes == 1) {
+    if (f->num_snakes == 1) {
         // Single player: show one score
         int score_x = 100;
         int score_y = 140;
-        int score = snakes[0].length - 3;
+        int score = f->lengths[0] - START_LENGTH;
         for (int i = 0; i < score && i < 20; i++) {
             draw_rect(score_x + (i * 6), score_y, 4, 4, 0x1F); // Cyan dots
         }
+    } else if (f->num_players == 1) {
+        // One player and bots: one row of dots per snake in its own colour
+        for (int s = 0; s < f->num_snakes; s++) {
+            int score = f->lengths[s] - START_LENGTH;
+            for (int i = 0; i < score && i < 15; i++) {
+                draw_rect(80 + (i * 6), 100 + (s * 14), 4, 4, snake_colors[s]);
+            }
+        }
     } else {
         // Multiplayer: show both scores
         // Player 1 (cyan)
         int score1_x = 80;
         int score1_y = 120;
-        int score1 = snakes[0].length - 3;
+        int score1 = f->lengths[0] - START_LENGTH;
         for (int i = 0; i < score1 && i < 15; i++) {
             draw_rect(score1_x + (i * 6), score1_y, 4, 4, 0x1F); // Cyan dots
         }
@@ -603,7 +1065,7 @@ void draw_game_over(void) {
         // Player 2 (red)
         int score2_x = 80;
         int score2_y = 160;
-        int score2 = snakes[1].length - 3;
+        int score2 = f->lengths[1] - START_LENGTH;
         for (int i = 0; i < score2 && i < 15; i++) {
             draw_rect(score2_x + (i * 6), score2_y, 4, 4, 0xE0); // Red dots
         }
@@ -612,9 +1074,9 @@ void draw_game_over(void) {
         int winner = -1;
         int is_draw = 0;
         
-        if (losing_player == 0) {
+        if (f->losing_player == 0) {
             winner = 1;  // Player 1 wins (left switches)
-        } else if (losing_player == 1) {
+        } else if (f->losing_player == 1) {
             winner = 0;  // Player 0 wins (right switches)
         } else {
             // No clear loser - use points to determine winner
@@ -652,11 +1114,11 @@ void draw_game_over(void) {
 /**
  * @brief Draws only the animated box for game over (no clearing or static elements).
  */
-void draw_game_over_animated(void) {
+void draw_game_over_animated(const GameFrame *f) {
     // Erase the old box area by drawing black over it (to handle shrinking)
     draw_rect(35, 75, 200, 5, 0x00);  // Clear the max width area
     // Draw the new animated box
-    draw_rect(35, 75, box_width, 5, 0xE0);
+    draw_rect(35, 75, f->box_width, 5, 0xE0);
 }
 
 /**
@@ -706,7 +1168,7 @@ void display_score_multi(int score1, int score2) {
  */
 void draw_pixel(int x, int y, uint8_t color) {
     if (x >= 0 && x < SCREEN_WIDTH && y >= 0 && y < SCREEN_HEIGHT) {
-        *(VGA_BUFFER + (y * SCREEN_WIDTH) + x) = color;
+        FB_STORE(VGA_BUFFER + (y * SCREEN_WIDTH) + x, color);
     }
 }
 
@@ -721,6 +1183,290 @@ void draw_rect(int x_start, int y_start, int width, int height, uint8_t color) {
     }
 }
 
+/**
+ * @brief Fills count adjacent screen cells on one row as a single span.
+ * Cells are always on screen, so unlike draw_rect there is no per-pixel
+ * clipping, and with CELL_SIZE a constant the row loop has a fixed trip count.
+ * @param cell Position of the leftmost cell on screen (world position minus camera)
+ * @param count Number of cells in the run
+ */
+void draw_cell_run(Point cell, int count, uint8_t color) {
+    volatile uint8_t *row = VGA_BUFFER + (cell.y * CELL_SIZE) * SCREEN_WIDTH + cell.x * CELL_SIZE;
+    int width = count * CELL_SIZE;
+    for (int y = 0; y < CELL_SIZE; y++) {
+        for (int x = 0; x < width; x++) {
+            FB_STORE(&row[x], color);
+        }
+        row += SCREEN_WIDTH;
+    }
+#ifdef HUD_ENABLE
+    if (hud_on) {
+        hud_damage(cell.x * CELL_SIZE, cell.y * CELL_SIZE, width, CELL_SIZE);
+    }
+#endif
+}
+
+// ============================================================================
+// FRAME-BUDGET WATCHDOG
+// ============================================================================
+
+/**
+ * @brief Records the duration of a timer handler and checks it against the next deadline.
+ * Load is the share of wall time spent in the handler over WD_LOAD_WINDOW;
+ * dropped ticks are task runs the scheduler had to skip because it fell a
+ * whole period behind.
+ * @param start_cycles mcycle value sampled on handler entry
+ * @param slack Cycles left before the next deadline, as returned by sched_arm()
+ */
+void watchdog_end(uint32_t start_cycles, int32_t slack) {
+    uint32_t now = perf_read_cycles();
+    uint32_t cycles = now - start_cycles;
+
+    wd_last_cycles = cycles;
+    if (cycles > wd_max_cycles) {
+        wd_max_cycles = cycles;
+    }
+    wd_last_slack = slack;
+    if (slack <= 0) {  // Next deadline already passed
+        wd_overruns++;
+    }
+
+    wd_busy_cycles += cycles;
+    wd_window_runs++;
+    uint32_t elapsed = now - wd_window_start;
+    if (elapsed < WD_LOAD_WINDOW) {
+        return;
+    }
+    wd_load_percent = wd_busy_cycles / (elapsed / 100);
+    wd_avg_cycles = wd_busy_cycles / wd_window_runs;
+    wd_busy_cycles = 0;
+    wd_window_runs = 0;
+    wd_window_start = now;
+
+    // Load bar: one LED per full 10% of the time, all ten lit when saturated
+    int lit = wd_load_percent / 10;
+    if (lit > 10) {
+        lit = 10;
+    }
+    uint32_t bar = (1u << lit) - 1;
+    if (bar != wd_led_bar) {  // Only touch the LEDs when the bar changes
+        wd_led_bar = bar;
+        IO_STORE(LEDS, bar);
+    }
+}
+
+/**
+ * @brief Prints the watchdog counters over the JTAG UART, one piece per call
+ * (see print_report_start).
+ * @return 0 once all pieces are out
+ */
+int watchdog_report(int piece) {
+    switch (piece) {
+    case 0:
+        print("\n[watchdog] last=");
+        print_dec(wd_last_cycles);
+        break;
+    case 1:
+        print(" avg=");
+        print_dec(wd_avg_cycles);
+        print(" max=");
+        print_dec(wd_max_cycles);
+        break;
+    case 2:
+        print(" load=");
+        print_dec(wd_load_percent);
+        print("% overruns=");
+        print_dec(wd_overruns);
+        break;
+    case 3:
+        print(" dropped=");
+        print_dec(sched_missed_runs() - wd_dropped_base);
+        break;
+    case 4:
+        print(" slack=");
+        if (wd_last_slack < 0) {
+            printc('-');
+        }
+        print_dec(wd_last_slack < 0 ? -wd_last_slack : wd_last_slack);
+        printc('\n');
+        break;
+    default:
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Records one handle_interrupt() call, whatever its cause, for the
+ * HUD's A and M fields. The watchdog only times the timer handler; this
+ * also counts switch interrupts.
+ * @param start_cycles mcycle when the handler was entered
+ */
+void irq_cost_end(uint32_t start_cycles) {
+#ifdef HUD_ENABLE
+    uint32_t now = perf_read_cycles();
+    uint32_t cycles = now - start_cycles;
+    if (cycles > irq_max_cycles) {
+        irq_max_cycles = cycles;
+    }
+    irq_busy_cycles += cycles;
+    irq_window_runs++;
+    if (now - irq_window_start >= HUD_INTERVAL) {
+        irq_avg_cycles = irq_busy_cycles / irq_window_runs;
+        irq_busy_cycles = 0;
+        irq_window_runs = 0;
+        irq_window_start = now;
+    }
+#else
+    (void) start_cycles;
+#endif
+}
+
+/**
+ * @brief Keeps the metrics overlay on top of what present() just drew and
+ * refreshes its numbers every HUD_INTERVAL. Does nothing unless built with
+ * HUD_ENABLE and switched on with SW4.
+ * @param redrawn 1 if present() drew over the screen wholesale, 0 if it
+ * repainted board cells (draw_cell_run reports those), -1 if it drew nothing
+ */
+void hud_update(int redrawn) {
+#ifdef HUD_ENABLE
+    if (!hud_on) {
+        return;
+    }
+    if (redrawn >= 0) {
+        hud_frames++;
+    }
+    if (redrawn > 0) {
+        hud_invalidate();
+    }
+
+    uint32_t now = perf_read_cycles();
+    uint32_t elapsed = now - hud_window_start;
+    if (elapsed >= HUD_INTERVAL) {
+        uint32_t fps = hud_frames * 100 / (elapsed / (SCHED_CPU_HZ / 100));
+        hud_frames = 0;
+        hud_window_start = now;
+
+        hud_clear_text();
+        hud_label(0, 0, 'F');
+        hud_number(0, 2, 4, fps);
+        hud_label(1, 0, 'A');
+        hud_number(1, 2, 7, irq_avg_cycles);
+        hud_label(2, 0, 'M');
+        hud_number(2, 2, 7, irq_max_cycles);
+        hud_label(3, 0, 'D');
+        hud_number(3, 2, 7, sched_missed_runs() - wd_dropped_base);
+        hud_label(4, 0, 'L');
+        for (int i = 0; i < view.num_snakes && view.state != STATE_MENU; i++) {
+            hud_number(4 + i / 4, 1 + (i % 4) * 5, 5, view.lengths[i]);
+        }
+    }
+    if (hud_paint()) {
+        hud_shrunk = 1;  // Panel got narrower; redraw what it uncovered
+    }
+#else
+    (void) redrawn;
+#endif
+}
+
+/**
+ * @brief Prints a summary of the latest published game state over the JTAG
+ * UART, one piece per call (see print_report_start): step and state, one
+ * piece per snake length, then food and ghosts. The numbers are taken from
+ * one whole frame when the first piece goes out, so they all belong to the
+ * same step.
+ * @return 0 once all pieces are out
+ */
+int frame_report(int piece) {
+    static struct {
+        uint32_t step;
+        int state, num_snakes;
+        int lengths[SNAKES_MAX];
+        Point food;
+        int ghosts;
+    } r;
+
+    if (piece == 0) {
+        read_frame(&view);
+        r.step = view.step;
+        r.state = view.state;
+        r.num_snakes = view.num_snakes;
+        for (int i = 0; i < view.num_snakes; i++) {
+            r.lengths[i] = view.lengths[i];
+        }
+        r.food = view.food;
+        r.ghosts = view.ghosts.count;
+
+        print("\n[frame] step=");
+        print_dec(r.step);
+        print(" state=");
+        print_dec(r.state);
+        return 1;
+    }
+    int snake = piece - 1;
+    if (snake < r.num_snakes) {
+        print(snake == 0 ? " len=" : "/");
+        print_dec(r.lengths[snake]);
+    } else if (snake == r.num_snakes) {
+        print(" food=");
+        print_dec(r.food.x);
+        printc(',');
+        print_dec(r.food.y);
+    } else if (snake == r.num_snakes + 1) {
+        print(" ghosts=");
+        print_dec(r.ghosts);
+        printc('\n');
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Handles single-character diagnostic requests from the JTAG UART.
+ * 'w' prints the watchdog counters, 'r' resets the maximum and overrun counts,
+ * 'p' prints the per-region hardware counter totals and starts a new sample,
+ * 'g' prints the latest published game state, 'm' prints section sizes and
+ * the stack high-water mark, and in profiling builds 'f'
+ * streams out the PC histogram and starts a new one.
+ * Called from the main loop so printing never eats into the frame budget;
+ * reports go out a piece at a time as the UART makes room for them.
+ */
+void poll_uart_commands(void) {
+    int c = readc();
+    if (c == 'w') {
+        print_report_start(watchdog_report);
+    } else if (c == 'p') {
+        if (print_report_start(perf_report)) {
+            perf_reset();  // perf_report() prints what this takes
+        }
+    } else if (c == 'r') {
+        wd_max_cycles = 0;
+#ifdef HUD_ENABLE
+        irq_max_cycles = 0;
+#endif
+        wd_overruns = 0;
+        wd_dropped_base = sched_missed_runs();
+    } else if (c == 'g') {
+        print_report_start(frame_report);
+    } else if (c == 'm') {
+        print_report_start(mem_report);
+    }
+#ifdef PROFILE_PC
+    if (c == 'f') {
+        prof_dump_start();
+    }
+#endif
+
+    if (print_report_poll()) {
+        return;  // One thing at a time on the UART
+    }
+#ifdef PROFILE_PC
+    prof_dump_poll();
+#endif
+}
+
 // ============================================================================
 // GAME LOGIC HELPER FUNCTIONS (OOP approach to avoid code duplication)
 // ============================================================================
@@ -731,59 +1477,198 @@ void draw_rect(int x_start, int y_start, int width, int height, uint8_t color) {
  * @return 1 if collision, 0 otherwise
  */
 int check_wall_collision(Point p) {
-    return (p.x < 0 || p.x >= SCREEN_WIDTH || p.y < 0 || p.y >= SCREEN_HEIGHT);
+    if (p.x < 0 || p.x >= GRID_WIDTH || p.y < 0 || p.y >= GRID_HEIGHT) {
+        return 1;  // Screen edge
+    }
+    return level_is_wall(p);
+}
+
+/**
+ * @brief Switches to another level. Walls that would land on a snake are
+ * left out so nobody dies from the switch, and the ghosts' distance field
+ * is rebuilt around the new walls.
+ * @param level Index into level_table
+ */
+void load_level(int level) {
+    current_level = level;
+    level_epoch++;
+    level_load(level);
+
+    for (int s = 0; s < snakes.count; s++) {
+        for (SnakeIter it = store_iter(&snakes, s); snake_iter_valid(&it); snake_iter_next(&it)) {
+            level_clear_wall(it.pos);
+        }
+    }
+    field_reset();
 }
 
 /**
- * @brief Checks if a point collides with a snake's body (excluding head).
+ * @brief Checks if a point is on any segment of any snake.
  * @param p Point to check
- * @param s Snake to check against
- * @return 1 if collision, 0 otherwise
+ * @return 1 if occupied, 0 otherwise
  */
-int check_snake_collision(Point p, Snake* s) {
-    for (int i = 1; i < s->length; i++) {
-        if (p.x == s->body[i].x && p.y == s->body[i].y) {
-            return 1;
+int check_any_snake(Point p) {
+    return store_owner(&snakes, p) >= 0;
+}
+
+/**
+ * @brief Sum of the human players' scores (START_LENGTH segments long =
+ * 0 points). Bots' points do not count towards speed-up, levels or ghosts.
+ */
+int human_score(void) {
+    int score = 0;
+    for (int i = 0; i < snakes.count; i++) {
+        if (snakes.kind[i] == PLAYER_HUMAN) {
+            score += snakes.length[i] - START_LENGTH;
         }
     }
-    return 0;
+    return score;
 }
 
 /**
- * @brief Moves a snake forward in its current direction.
- * @param s Snake to move
+ * @brief Finds the human player who loses when human player i wins: the
+ * other human snake, going by the snake kinds.
+ * @return Its snake index, or -1 with only one human player
  */
-void move_snake(Snake* s) {
-    Point new_head = {
-        s->body[0].x + s->direction.x,
-        s->body[0].y + s->direction.y
-    };
-    
-    // Shift body segments
-    for (int i = s->length - 1; i > 0; i--) {
-        s->body[i] = s->body[i - 1];
+int rival_player(int i) {
+    if (num_players < 2) {
+        return -1;
+    }
+    for (int k = 0; k < snakes.count; k++) {
+        if (k != i && snakes.kind[k] == PLAYER_HUMAN) {
+            return k;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Checks that a fresh snake for bot i fits at spawn sp: every cell
+ * free of walls, ghosts, food and snakes other than bot i itself.
+ */
+static int spawn_is_free(const Spawn *sp, int i) {
+    for (int n = 0; n < START_LENGTH; n++) {
+        Point p = {sp->head.x - SNAKE_DX[sp->direction] * n, sp->head.y - SNAKE_DY[sp->direction] * n};
+        int owner = store_owner(&snakes, p);
+        if (level_is_wall(p) || (owner >= 0 && owner != i) || ghosts_at(&ghosts, p)
+            || (p.x == food.x && p.y == food.y)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Starts a crashed bot again, START_LENGTH long, at the first free
+ * spawn point from its own onwards. If every one is blocked the bot stays
+ * where it is and tries again when it next crashes.
+ */
+void respawn_bot(int i) {
+    for (int k = 0; k < SNAKES_MAX; k++) {
+        const Spawn *sp = &spawns[(i + k) % SNAKES_MAX];
+        if (spawn_is_free(sp, i)) {
+            store_place(&snakes, i, sp->head, START_LENGTH, sp->direction);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Advances the shared distance field from the snake heads and,
+ * every GHOST_STEP_DIV steps, moves the ghosts one cell down it.
+ * The field is updated every step so it never falls far behind the heads.
+ */
+void update_ghosts(void) {
+    field_update(snakes.head, snakes.count);
+
+    ghost_ticks++;
+    if (ghost_ticks >= GHOST_STEP_DIV) {
+        ghost_ticks = 0;
+        ghosts_step(&ghosts, &snakes);
+    }
+}
+
+/**
+ * @brief Tops the ghosts up to one per GHOST_SCORE_STEP points, spawning each
+ * on a free cell at least GHOST_SPAWN_MIN_DIST from the nearest head.
+ */
+void spawn_ghosts(void) {
+    int target = human_score() / GHOST_SCORE_STEP;
+
+    while (ghosts.list.count < target && ghosts.list.count < GHOSTS_MAX) {
+        Point p;
+        int found = 0;
+        for (int attempts = 0; attempts < 100 && !found; attempts++) {
+            p.x = random_int(0, GRID_WIDTH - 1);
+            p.y = random_int(0, GRID_HEIGHT - 1);
+            uint32_t d = field_distance(p);
+            found = d != FIELD_UNREACHED && d >= GHOST_SPAWN_MIN_DIST
+                 && !(p.x == food.x && p.y == food.y) && !check_any_snake(p)
+                 && !ghosts_at(&ghosts, p);
+        }
+        if (!found) {
+            break;  // Board too crowded; try again on the next point
+        }
+        ghosts_spawn(&ghosts, p);
     }
-    s->body[0] = new_head;
+}
+
+/**
+ * @brief Sets this step's direction for every snake not steered by the
+ * switches: bots look for the food, replays take their next scripted move.
+ */
+void steer_snakes(void) {
+    for (int i = 0; i < snakes.count; i++) {
+        if (snakes.kind[i] == PLAYER_BOT) {
+            snakes.dir[i] = bot_direction(i);
+        } else if (snakes.kind[i] == PLAYER_REPLAY && snakes.script_length[i] > 0) {
+            snakes.dir[i] = snakes.script[i][snakes.script_pos[i]];
+            snakes.script_pos[i] = (snakes.script_pos[i] + 1) % snakes.script_length[i];
+        }
+    }
+}
+
+/**
+ * @brief Greedy bot: of the moves a player could make (straight on or a turn,
+ * never reversing), takes the safe one closest to the food. Only looks one
+ * cell ahead, so bots can still trap themselves.
+ * @param i Snake to steer
+ * @return Move code for this step
+ */
+int bot_direction(int i) {
+    int current = snakes.dir[i];
+    int best = current;
+    int best_dist = -1;
+    for (int code = 0; code < 4; code++) {
+        // Same axis as now: only straight on is allowed
+        if ((code >> 1) == (current >> 1) && code != current) {
+            continue;
+        }
+        Point p = {snakes.head[i].x + SNAKE_DX[code], snakes.head[i].y + SNAKE_DY[code]};
+        if (check_wall_collision(p) || check_any_snake(p) || ghosts_at(&ghosts, p)) {
+            continue;
+        }
+        int dx = p.x - food.x;
+        int dy = p.y - food.y;
+        int dist = (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy);
+        if (best_dist < 0 || dist < best_dist) {
+            best = code;
+            best_dist = dist;
+        }
+    }
+    return best;
 }
 
 /**
  * @brief Updates snake direction based on switch input.
- * @param s Snake to update
+ * @param i Snake to update
  * @param sw_bits Two-bit switch value (00, 01, 10, 11)
  */
-void update_snake_direction(Snake* s, uint32_t sw_bits) {
-    // Only change direction if not opposite to current direction
-    if (sw_bits == 0b00 && s->direction.y == 0) { 
-        s->direction = (Point){0, -10};  // Up
-    } 
-    else if (sw_bits == 0b01 && s->direction.y == 0) { 
-        s->direction = (Point){0, 10};   // Down
-    } 
-    else if (sw_bits == 0b10 && s->direction.x == 0) {
-        s->direction = (Point){-10, 0};  // Left
-    } 
-    else if (sw_bits == 0b11 && s->direction.x == 0) {
-        s->direction = (Point){10, 0};   // Right
+void update_snake_direction(int i, uint32_t sw_bits) {
+    // Switch codes equal move codes; bit 1 tells the axis (0 = up/down, 1 = left/right).
+    // Only change direction when turning onto the other axis, never reversing.
+    if ((sw_bits >> 1) != ((uint32_t) snakes.dir[i] >> 1)) {
+        snakes.dir[i] = sw_bits;
     }
 }
 
@@ -0,0 +1,59 @@
+#ifndef SNAKE_CONFIG_H
+#define SNAKE_CONFIG_H
+
+/*
+ * Compile-time grid geometry.
+ * The screen shows a VIEW_WIDTH x VIEW_HEIGHT window of cells, derived from
+ * SCREEN_* and CELL_SIZE, onto a GRID_WIDTH x GRID_HEIGHT world. By default
+ * the world is one screen; -DGRID_WIDTH=256 -DGRID_HEIGHT=256 makes a larger
+ * world the camera scrolls over (see GAME_DEFS in the Makefile). Game
+ * coordinates are in world cells; only drawing subtracts the camera and
+ * multiplies by CELL_SIZE, which the compiler turns into a shift when the
+ * cell size is a power of two.
+ */
+
+// --- Screen Dimensions ---
+#define SCREEN_WIDTH 320
+#define SCREEN_HEIGHT 240
+
+// --- Cell Size (pixels per grid cell: 20, 10, 5, 4, 2 and 1 all fit the screen) ---
+#ifndef CELL_SIZE
+#define CELL_SIZE 10
+#endif
+
+#if (SCREEN_WIDTH % CELL_SIZE) != 0 || (SCREEN_HEIGHT % CELL_SIZE) != 0
+#error "CELL_SIZE must divide both screen dimensions"
+#endif
+
+// --- Viewport Dimensions (cells on screen) ---
+#define VIEW_WIDTH  (SCREEN_WIDTH / CELL_SIZE)
+#define VIEW_HEIGHT (SCREEN_HEIGHT / CELL_SIZE)
+#define VIEW_CELLS  (VIEW_WIDTH * VIEW_HEIGHT)
+
+// --- Grid Dimensions (world size in cells) ---
+#ifndef GRID_WIDTH
+#define GRID_WIDTH  VIEW_WIDTH
+#endif
+#ifndef GRID_HEIGHT
+#define GRID_HEIGHT VIEW_HEIGHT
+#endif
+#define GRID_CELLS  (GRID_WIDTH * GRID_HEIGHT)
+
+#if GRID_WIDTH < VIEW_WIDTH || GRID_HEIGHT < VIEW_HEIGHT
+#error "The world (GRID_WIDTH x GRID_HEIGHT) must be at least one screen"
+#endif
+
+// Room for the eight spawn points to be apart (labmain.c spawns[]); rules out CELL_SIZE=40
+#if GRID_WIDTH < 16 || GRID_HEIGHT < 12
+#error "The world must be at least 16 x 12 cells"
+#endif
+
+// Smallest power of two >= n, as a constant expression (smears the top bit down)
+#define SMEAR1_(n)   ((n) | ((n) >> 1))
+#define SMEAR2_(n)   (SMEAR1_(n) | (SMEAR1_(n) >> 2))
+#define SMEAR4_(n)   (SMEAR2_(n) | (SMEAR2_(n) >> 4))
+#define SMEAR8_(n)   (SMEAR4_(n) | (SMEAR4_(n) >> 8))
+#define SMEAR16_(n)  (SMEAR8_(n) | (SMEAR8_(n) >> 16))
+#define POW2_CEIL(n) (SMEAR16_((n) - 1) + 1)
+
+#endif
@@ -0,0 +1,179 @@
+#include "snake-ghosts.h"
+#include "snake-level.h"
+
+// One BFS buffer: a cell's distance is only valid if its stamp matches the
+// buffer's generation, so starting a new wave never has to clear the array.
+typedef struct {
+    FieldIndex dist[GRID_CELLS];
+    uint16_t stamp[GRID_CELLS];
+    uint16_t generation;
+} FieldBuffer;
+
+static FieldBuffer buffers[2];
+static FieldBuffer *published = &buffers[0];  // What ghosts read
+static FieldBuffer *building = &buffers[1];   // Wave in progress
+
+static FieldIndex queue[GRID_CELLS];
+static uint32_t queue_head = 0;
+static uint32_t queue_tail = 0;
+static int wave_active = 0;
+
+static inline uint32_t cell_index(Point p) {
+    return (uint32_t) p.y * GRID_WIDTH + (uint32_t) p.x;
+}
+
+static inline int in_grid(Point p) {
+    return p.x >= 0 && p.x < GRID_WIDTH && p.y >= 0 && p.y < GRID_HEIGHT;
+}
+
+static void next_generation(FieldBuffer *b) {
+    b->generation++;
+    if (b->generation == 0) {
+        // Stamps wrapped: clear them once every 65535 waves
+        for (uint32_t i = 0; i < GRID_CELLS; i++) {
+            b->stamp[i] = 0;
+        }
+        b->generation = 1;
+    }
+}
+
+static inline void visit(FieldBuffer *b, uint32_t cell, FieldIndex dist) {
+    b->stamp[cell] = b->generation;
+    b->dist[cell] = dist;
+    queue[queue_tail++] = cell;
+}
+
+/**
+ * @brief Forgets the current field, e.g. when a new game starts.
+ */
+void field_reset(void) {
+    next_generation(published);
+    wave_active = 0;
+}
+
+/**
+ * @brief Advances the distance field by up to FIELD_BUDGET cells.
+ * If no wave is running, a new one starts from the given roots.
+ * @param roots Cells at distance 0 (the snake heads)
+ * @param num_roots Number of roots
+ */
+void field_update(const Point *roots, int num_roots) {
+    if (!wave_active) {
+        next_generation(building);
+        queue_head = queue_tail = 0;
+        for (int i = 0; i < num_roots; i++) {
+            if (in_grid(roots[i])) {
+                visit(building, cell_index(roots[i]), 0);
+            }
+        }
+        wave_active = 1;
+    }
+
+    for (int budget = FIELD_BUDGET; budget > 0 && queue_head < queue_tail; budget--) {
+        uint32_t cell = queue[queue_head++];
+        int x = cell % GRID_WIDTH;
+        int y = cell / GRID_WIDTH;
+        FieldIndex next = building->dist[cell] + 1;
+
+        for (int code = 0; code < 4; code++) {
+            Point n = {x + SNAKE_DX[code], y + SNAKE_DY[code]};
+            if (!in_grid(n) || level_is_wall(n)) {
+                continue;
+            }
+            uint32_t ni = cell_index(n);
+            if (building->stamp[ni] != building->generation) {
+                visit(building, ni, next);
+            }
+        }
+    }
+
+    if (queue_head == queue_tail) {
+        // Wave complete: publish it
+        FieldBuffer *done = building;
+        building = published;
+        published = done;
+        wave_active = 0;
+    }
+}
+
+/**
+ * @brief Distance from p to the nearest root in the published field.
+ * @return FIELD_UNREACHED if p is off the grid or was not reached
+ */
+uint32_t field_distance(Point p) {
+    if (!in_grid(p)) {
+        return FIELD_UNREACHED;
+    }
+    uint32_t cell = cell_index(p);
+    return published->stamp[cell] == published->generation ? published->dist[cell] : FIELD_UNREACHED;
+}
+
+/**
+ * @brief Removes every ghost. Only the cells they were on are cleared.
+ */
+void ghosts_reset(Ghosts *g) {
+    for (int i = 0; i < g->list.count; i++) {
+        g->occupied[cell_index(g->list.pos[i])]--;
+    }
+    g->list.count = 0;
+}
+
+/**
+ * @brief Adds a ghost at p.
+ * @return 1 if added, 0 if the ghost table is full
+ */
+int ghosts_spawn(Ghosts *g, Point p) {
+    if (g->list.count == GHOSTS_MAX || !in_grid(p)) {
+        return 0;
+    }
+    g->list.pos[g->list.count++] = p;
+    g->occupied[cell_index(p)]++;
+    return 1;
+}
+
+/**
+ * @brief Checks whether a ghost may step onto p: not onto another ghost, and
+ * not onto a snake's body, though onto a head it is hunting.
+ */
+static int ghost_can_enter(const Ghosts *g, const SnakeStore *snakes, Point p) {
+    int owner = store_owner(snakes, p);
+    if (owner >= 0 && (snakes->head[owner].x != p.x || snakes->head[owner].y != p.y)) {
+        return 0;
+    }
+    return !ghosts_at(g, p);
+}
+
+/**
+ * @brief Moves every ghost one cell downhill in the distance field, to the
+ * best neighbour it can enter (see ghost_can_enter). Ghosts move one after
+ * another, so each sees where the earlier ones went and no two end up on
+ * the same cell; a ghost with nowhere better to go stays put.
+ */
+void ghosts_step(Ghosts *g, const SnakeStore *snakes) {
+    for (int i = 0; i < g->list.count; i++) {
+        Point p = g->list.pos[i];
+        uint32_t best = field_distance(p);
+        Point best_pos = p;
+        for (int code = 0; code < 4; code++) {
+            Point n = {p.x + SNAKE_DX[code], p.y + SNAKE_DY[code]};
+            uint32_t d = field_distance(n);  // Off-grid and walls are FIELD_UNREACHED
+            if (d < best && ghost_can_enter(g, snakes, n)) {
+                best = d;
+                best_pos = n;
+            }
+        }
+        if (best_pos.x != p.x || best_pos.y != p.y) {
+            g->occupied[cell_index(p)]--;
+            g->occupied[cell_index(best_pos)]++;
+            g->list.pos[i] = best_pos;
+        }
+    }
+}
+
+/**
+ * @brief Checks whether any ghost is at p, with one occupancy grid lookup.
+ * @return 1 if so, 0 otherwise (always 0 off the grid)
+ */
+int ghosts_at(const Ghosts *g, Point p) {
+    return in_grid(p) && g->occupied[cell_index(p)] != 0;
+}
@@ -0,0 +1,69 @@
+#ifndef SNAKE_GHOSTS_H
+#define SNAKE_GHOSTS_H
+
+#include <stdint.h>
+#include "snake-config.h"
+#include "snake-pack.h"
+#include "snake-store.h"
+
+/*
+ * Ghost enemies.
+ * All ghosts navigate by one shared BFS distance field rooted at the snake
+ * heads and flowing around level walls, so a ghost step is a lookup of four
+ * neighbours and adding ghosts costs almost nothing. An occupancy grid,
+ * kept up to date as ghosts spawn and move, answers "is there a ghost here"
+ * without walking the ghost list.
+ *
+ * The field is not repaired in place as the heads move; it is rebuilt from
+ * scratch with the cost spread out. Each game step advances a fresh BFS
+ * wave by at most FIELD_BUDGET cells, and the finished wave is published by
+ * swapping buffers, so the per-step cost is bounded and does not depend on
+ * the number of ghosts. FIELD_BUDGET scales with the grid so that a wave
+ * takes at most FIELD_WAVE_STEPS steps: on the default 32x24 grid every
+ * step finishes a whole wave, and on a 256x256 world ghosts follow a field
+ * up to four steps (about 1.3 s) old.
+ */
+
+#define GHOSTS_MAX 48
+
+// Game steps a BFS wave may take at most
+#define FIELD_WAVE_STEPS 4
+
+// Cells the BFS wave may visit per game step
+#ifndef FIELD_BUDGET
+#if GRID_CELLS / FIELD_WAVE_STEPS > 1024
+#define FIELD_BUDGET ((GRID_CELLS + FIELD_WAVE_STEPS - 1) / FIELD_WAVE_STEPS)
+#else
+#define FIELD_BUDGET 1024
+#endif
+#endif
+
+#if GRID_CELLS > 0xFFFF
+typedef uint32_t FieldIndex;
+#define FIELD_UNREACHED 0xFFFFFFFFu
+#else
+typedef uint16_t FieldIndex;
+#define FIELD_UNREACHED 0xFFFFu
+#endif
+
+// Where the ghosts are; all the renderer needs, so this is what gets published
+typedef struct {
+    int count;
+    Point pos[GHOSTS_MAX];
+} GhostList;
+
+typedef struct {
+    GhostList list;
+    uint8_t occupied[GRID_CELLS];  // Ghosts on each cell, so ghosts_at is one lookup
+} Ghosts;
+
+void field_reset(void);
+void field_update(const Point *roots, int num_roots);
+uint32_t field_distance(Point p);
+
+void ghosts_reset(Ghosts *g);
+int ghosts_spawn(Ghosts *g, Point p);
+void ghosts_step(Ghosts *g, const SnakeStore *snakes);
+int ghosts_at(const Ghosts *g, Point p);
+
+#endif
@@ -0,0 +1,147 @@
+#include "snake-hud.h"
+#include "dtekv-hal.h"
+#include "snake-config.h"
+
+#define HUD_FG 0xFF
+#define HUD_BG 0x00
+#define UNKNOWN 0  // In hud_shown: screen contents not known
+
+static char hud_text[HUD_ROWS][HUD_COLS];   // Text to show
+static char hud_shown[HUD_ROWS][HUD_COLS];  // Text on screen now
+static int hud_extent[HUD_ROWS];            // Columns of each row the panel covers on screen
+
+// 3x5 glyphs, row by row from the top, leftmost pixel in the highest bit
+static const uint16_t digit_glyphs[10] = {
+    0x7B6F, 0x2C97, 0x73E7, 0x73CF, 0x5BC9, 0x79CF, 0x79EF, 0x7249, 0x7BEF, 0x7BCF
+};
+
+static uint16_t glyph(char c) {
+    if (c >= '0' && c <= '9') {
+        return digit_glyphs[c - '0'];
+    }
+    switch (c) {
+    case 'A': return 0x2BED;
+    case 'D': return 0x6B6E;
+    case 'F': return 0x79A4;
+    case 'L': return 0x4927;
+    case 'M': return 0x5FED;
+    default:  return 0;
+    }
+}
+
+/**
+ * @brief Blanks the text. Nothing is drawn until hud_paint().
+ */
+void hud_clear_text(void) {
+    for (int row = 0; row < HUD_ROWS; row++) {
+        for (int col = 0; col < HUD_COLS; col++) {
+            hud_text[row][col] = ' ';
+        }
+    }
+}
+
+void hud_label(int row, int col, char c) {
+    hud_text[row][col] = c;
+}
+
+/**
+ * @brief Writes value right-aligned in width characters, showing all nines
+ * if it does not fit.
+ */
+void hud_number(int row, int col, int width, uint32_t value) {
+    uint32_t limit = 1;
+    for (int i = 0; i < width; i++) {
+        limit *= 10;
+    }
+    if (value >= limit) {
+        value = limit - 1;
+    }
+    for (int i = width - 1; i >= 0; i--) {
+        int blank = (value == 0 && i != width - 1);  // Leading zero
+        hud_text[row][col + i] = blank ? ' ' : '0' + value % 10;
+        value /= 10;
+    }
+}
+
+/**
+ * @brief Forgets what is on screen, e.g. after a full-screen redraw, so the
+ * next hud_paint() draws the whole panel.
+ */
+void hud_invalidate(void) {
+    for (int row = 0; row < HUD_ROWS; row++) {
+        for (int col = 0; col < HUD_COLS; col++) {
+            hud_shown[row][col] = UNKNOWN;
+        }
+        hud_extent[row] = 0;
+    }
+}
+
+/**
+ * @brief Marks the characters under a rectangle of screen pixels as drawn
+ * over. Cheap when the rectangle misses the panel, which it mostly does.
+ */
+void hud_damage(int x, int y, int width, int height) {
+    int x0 = x - HUD_X, y0 = y - HUD_Y;
+    if (x0 >= HUD_WIDTH || y0 >= HUD_HEIGHT || x0 + width <= 0 || y0 + height <= 0) {
+        return;
+    }
+    int col0 = x0 < 0 ? 0 : x0 / HUD_CHAR_WIDTH;
+    int row0 = y0 < 0 ? 0 : y0 / HUD_CHAR_HEIGHT;
+    int col1 = (x0 + width - 1) / HUD_CHAR_WIDTH;
+    int row1 = (y0 + height - 1) / HUD_CHAR_HEIGHT;
+    for (int row = row0; row <= row1 && row < HUD_ROWS; row++) {
+        for (int col = col0; col <= col1 && col < HUD_COLS; col++) {
+            hud_shown[row][col] = UNKNOWN;
+        }
+    }
+}
+
+/**
+ * @brief Draws one character cell, background included.
+ */
+static void paint_char(int row, int col, char c) {
+    uint16_t bits = glyph(c);
+    volatile uint8_t *line = VGA_MEM(DTEKV_VGA_BASE) + (HUD_Y + row * HUD_CHAR_HEIGHT) * SCREEN_WIDTH
+                             + HUD_X + col * HUD_CHAR_WIDTH;
+    for (int y = 0; y < HUD_CHAR_HEIGHT; y++) {
+        int glyph_row = y / HUD_SCALE;  // Row 5 is the gap below the glyph
+        for (int x = 0; x < HUD_CHAR_WIDTH; x++) {
+            int glyph_col = x / HUD_SCALE;
+            int on = glyph_row < 5 && glyph_col < 3 && ((bits >> (14 - glyph_row * 3 - glyph_col)) & 1);
+            FB_STORE(&line[x], on ? HUD_FG : HUD_BG);
+        }
+        line += SCREEN_WIDTH;
+    }
+}
+
+/**
+ * @brief Repaints the characters that differ from what is on screen. Each
+ * row's panel ends at its last non-blank character; the screen beyond it
+ * is left alone.
+ * @return Nonzero if a row got shorter, leaving panel pixels the caller
+ * must draw over (followed by hud_invalidate())
+ */
+int hud_paint(void) {
+    int shrunk = 0;
+    for (int row = 0; row < HUD_ROWS; row++) {
+        int extent = HUD_COLS;
+        while (extent > 0 && hud_text[row][extent - 1] == ' ') {
+            extent--;
+        }
+        if (extent < hud_extent[row]) {
+            shrunk = 1;
+        } else {
+            hud_extent[row] = extent;
+        }
+        for (int col = 0; col < HUD_COLS; col++) {
+            char c = hud_text[row][col];
+            if (col >= extent) {
+                hud_shown[row][col] = UNKNOWN;  // Not ours; paint it if the row grows
+            } else if (hud_shown[row][col] != c) {
+                paint_char(row, col, c);
+                hud_shown[row][col] = c;
+            }
+        }
+    }
+    return shrunk;
+}
@@ -0,0 +1,34 @@
+#ifndef SNAKE_HUD_H
+#define SNAKE_HUD_H
+
+#include <stdint.h>
+
+/*
+ * Text overlay for live metrics in the top-left corner of the screen.
+ * The caller lays out the text with hud_label() and hud_number(), then
+ * hud_paint() repaints only the characters whose text changed since they
+ * were last drawn, or that other drawing covered (hud_damage(),
+ * hud_invalidate()). Characters are a 3x5 font at double size on an opaque
+ * panel, digits and the few letters the labels need. The panel covers each
+ * row only up to its last non-blank character, so unused cells of the
+ * HUD_ROWS x HUD_COLS grid leave the screen underneath visible.
+ */
+
+#define HUD_ROWS 6
+#define HUD_COLS 21
+#define HUD_X 2                                   // Panel position on screen
+#define HUD_Y 2
+#define HUD_SCALE 2
+#define HUD_CHAR_WIDTH  (4 * HUD_SCALE)           // 3 px glyph + 1 px gap
+#define HUD_CHAR_HEIGHT (5 * HUD_SCALE + 1)
+#define HUD_WIDTH  (HUD_COLS * HUD_CHAR_WIDTH)
+#define HUD_HEIGHT (HUD_ROWS * HUD_CHAR_HEIGHT)
+
+void hud_clear_text(void);
+void hud_label(int row, int col, char c);
+void hud_number(int row, int col, int width, uint32_t value);
+void hud_invalidate(void);
+void hud_damage(int x, int y, int width, int height);
+int hud_paint(void);
+
+#endif
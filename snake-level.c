@@ -0,0 +1,65 @@
+#include "snake-level.h"
+
+LevelWalls level_layouts[2];
+int level_active = 0;
+
+/**
+ * @brief Sets the wall bits for cells x0..x1-1 of a grid row, a word at a time.
+ */
+static void set_wall_run(LevelWalls *walls, int y, int x0, int x1) {
+    while (x0 < x1) {
+        int word = x0 >> 5;
+        int bit = x0 & 31;
+        int n = 32 - bit;
+        if (n > x1 - x0) {
+            n = x1 - x0;
+        }
+        uint32_t mask = (n == 32) ? 0xFFFFFFFFu : ((1u << n) - 1) << bit;
+        (*walls)[y][word] |= mask;
+        x0 += n;
+    }
+}
+
+/**
+ * @brief Unpacks a level into the spare collision grid and makes it the
+ * active one. The grid it replaces is left as it was.
+ * Level cells are scaled to grid cells, so the same layout works for any CELL_SIZE.
+ * @param level Index into level_table
+ */
+void level_load(int level) {
+    LevelWalls *walls = &level_layouts[!level_active];
+    for (int y = 0; y < GRID_HEIGHT; y++) {
+        for (int w = 0; w < LEVEL_WORDS; w++) {
+            (*walls)[y][w] = 0;
+        }
+    }
+
+    const uint8_t *rle = level_table[level].rle;
+    for (int ly = 0; ly < LEVEL_HEIGHT; ly++) {
+        int gy0 = ly * GRID_HEIGHT / LEVEL_HEIGHT;
+        int gy1 = (ly + 1) * GRID_HEIGHT / LEVEL_HEIGHT;
+        int lx = 0;
+        int wall = 0;
+        while (lx < LEVEL_WIDTH) {
+            int run = *rle++;
+            if (wall && run > 0) {
+                int gx0 = lx * GRID_WIDTH / LEVEL_WIDTH;
+                int gx1 = (lx + run) * GRID_WIDTH / LEVEL_WIDTH;
+                for (int gy = gy0; gy < gy1; gy++) {
+                    set_wall_run(walls, gy, gx0, gx1);
+                }
+            }
+            lx += run;
+            wall = !wall;
+        }
+    }
+    level_active = !level_active;
+}
+
+/**
+ * @brief Opens up a single cell of the active layout (e.g. where a snake
+ * already is when a level loads).
+ */
+void level_clear_wall(Point p) {
+    level_layouts[level_active][p.y][p.x >> 5] &= ~(1u << (p.x & 31));
+}
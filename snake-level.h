@@ -0,0 +1,50 @@
+#ifndef SNAKE_LEVEL_H
+#define SNAKE_LEVEL_H
+
+#include <stdint.h>
+#include "snake-config.h"
+#include "snake-pack.h"
+
+/*
+ * Levels: wall layouts stored in .rodata as run-length encoded rows
+ * (generated into snake-levels.c by host/levelc.py from the levels/ layouts).
+ * Loading a level unpacks it straight into a one-bit-per-cell collision
+ * grid, so switching levels costs one decompression and both collision
+ * checks and drawing the visible part of the level are bit lookups.
+ */
+
+// Layouts are authored at this size and scaled to the grid when loaded
+#define LEVEL_WIDTH  32
+#define LEVEL_HEIGHT 24
+
+#define LEVEL_WORDS ((GRID_WIDTH + 31) / 32)
+
+typedef struct {
+    const char *name;
+    const uint8_t *rle;  // Per row: open, wall, open, ... runs adding up to LEVEL_WIDTH
+} LevelData;
+
+extern const LevelData level_table[];
+extern const int level_count;
+
+// Collision grid, one bit per cell; bit x of word x / 32 in row y
+typedef uint32_t LevelWalls[GRID_HEIGHT][LEVEL_WORDS];
+
+// Two grids: level_load() unpacks into the one not in use and then switches,
+// so the previous layout stays intact for a reader that is still using it
+extern LevelWalls level_layouts[2];
+extern int level_active;  // Index of the layout the game collides with
+
+// p must be on the grid
+static inline int level_wall_in(const LevelWalls *walls, Point p) {
+    return ((*walls)[p.y][p.x >> 5] >> (p.x & 31)) & 1;
+}
+
+static inline int level_is_wall(Point p) {
+    return level_wall_in(&level_layouts[level_active], p);
+}
+
+void level_load(int level);
+void level_clear_wall(Point p);
+
+#endif
@@ -0,0 +1,43 @@
+// Generated by host/levelc.py from the layouts in levels/ - do not edit.
+// Regenerate with: make levels
+
+#include "snake-level.h"
+
+// open: 0 wall cells
+static const uint8_t level_0_rle[24] = {
+    32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32,
+    32, 32, 32, 32, 32, 32, 32, 32,
+};
+
+// pillars: 16 wall cells
+static const uint8_t level_1_rle[40] = {
+    32, 32, 32, 32, 32, 32, 8, 2, 12, 2, 8, 8, 2, 12, 2, 8,
+    32, 32, 32, 32, 32, 32, 32, 32, 8, 2, 12, 2, 8, 8, 2, 12,
+    2, 8, 32, 32, 32, 32, 32, 32,
+};
+
+// cross: 48 wall cells
+static const uint8_t level_2_rle[56] = {
+    32, 32, 32, 15, 2, 15, 15, 2, 15, 15, 2, 15, 15, 2, 15, 15,
+    2, 15, 15, 2, 15, 32, 32, 6, 6, 8, 6, 6, 6, 6, 8, 6,
+    6, 32, 32, 15, 2, 15, 15, 2, 15, 15, 2, 15, 15, 2, 15, 15,
+    2, 15, 15, 2, 15, 32, 32, 32,
+};
+
+// box: 44 wall cells
+static const uint8_t level_3_rle[64] = {
+    32, 32, 32, 32, 32, 32, 8, 7, 2, 7, 8, 8, 1, 14, 1, 8,
+    8, 1, 14, 1, 8, 8, 1, 14, 1, 8, 8, 1, 14, 1, 8, 32,
+    32, 8, 1, 14, 1, 8, 8, 1, 14, 1, 8, 8, 1, 14, 1, 8,
+    8, 1, 14, 1, 8, 8, 7, 2, 7, 8, 32, 32, 32, 32, 32, 32,
+};
+
+// 184 bytes of run lengths for 4 levels
+const LevelData level_table[] = {
+    {"open", level_0_rle},
+    {"pillars", level_1_rle},
+    {"cross", level_2_rle},
+    {"box", level_3_rle},
+};
+
+const int level_count = 4;
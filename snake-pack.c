@@ -0,0 +1,31 @@
+#include "snake-pack.h"
+
+static void set_move_code(SnakeBody *b, uint32_t slot, int code) {
+    slot &= SNAKE_RING_MASK;
+    int shift = (slot & 3) * 2;
+    b->moves[slot >> 2] = (b->moves[slot >> 2] & ~(0x3 << shift)) | (code << shift);
+}
+
+/**
+ * @brief Lays out a straight snake whose head has just moved in direction code.
+ * @param b Body to initialize
+ * @param length Number of segments
+ * @param code Move code; the body trails behind the head, opposite to it
+ */
+void snake_body_init(SnakeBody *b, int length, int code) {
+    b->head_slot = 0;
+    for (int i = 1; i < length; i++) {
+        set_move_code(b, i, code);
+    }
+}
+
+/**
+ * @brief Records a move of the head one cell in direction code. The segment
+ * that was the tail stays in the ring just past the end, so the owner can
+ * keep it (grow) or let it drop.
+ */
+void snake_body_push(SnakeBody *b, int code) {
+    // The old head becomes segment 1, reached by this move
+    set_move_code(b, b->head_slot, code);
+    b->head_slot = (b->head_slot - 1) & SNAKE_RING_MASK;
+}
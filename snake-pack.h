@@ -0,0 +1,84 @@
+#ifndef SNAKE_PACK_H
+#define SNAKE_PACK_H
+
+#include <stdint.h>
+#include "snake-config.h"
+
+/*
+ * Bit-packed snake body.
+ * Only the head position is stored (by the owner, see snake-store.h); every
+ * other segment is a 2-bit move code (four per byte) saying which way the
+ * snake travelled to get from that segment to the one in front of it. The
+ * codes live in a ring, so moving the head and dropping the tail is O(1) and
+ * growing just stops dropping it.
+ */
+
+typedef struct {
+    int x, y;
+} Point;
+
+// Move codes, numbered like the two direction switches (SW0-1)
+#define SNAKE_UP    0
+#define SNAKE_DOWN  1
+#define SNAKE_LEFT  2
+#define SNAKE_RIGHT 3
+
+// Ring capacity in segments: a power of two with room for every grid cell,
+// up to SNAKE_LENGTH_LIMIT so large worlds do not make every body huge
+#define SNAKE_LENGTH_LIMIT 4096
+#if GRID_CELLS + 1 < SNAKE_LENGTH_LIMIT
+#define SNAKE_RING_CAPACITY POW2_CEIL(GRID_CELLS + 1)
+#else
+#define SNAKE_RING_CAPACITY SNAKE_LENGTH_LIMIT
+#endif
+#define SNAKE_RING_MASK (SNAKE_RING_CAPACITY - 1)
+
+// Longest body a ring can hold; on grids that reach SNAKE_LENGTH_LIMIT the
+// game treats a snake this long as a winner (see update_game)
+#define SNAKE_LENGTH_MAX (SNAKE_RING_CAPACITY - 1)
+
+// Grid offset of one move in each direction
+static const int8_t SNAKE_DX[4] = {0, 0, -1, 1};
+static const int8_t SNAKE_DY[4] = {-1, 1, 0, 0};
+
+typedef struct {
+    uint32_t head_slot;  // Ring slot of segment 0; segment i uses head_slot + i
+    uint8_t moves[SNAKE_RING_CAPACITY / 4];
+} SnakeBody;
+
+// Walks the segments from head to tail
+typedef struct {
+    const SnakeBody *body;
+    Point pos;           // Position of the current segment
+    int index;           // Current segment, 0 = head
+    int length;
+    uint32_t slot;
+} SnakeIter;
+
+static inline int snake_move_code(const SnakeBody *b, uint32_t slot) {
+    slot &= SNAKE_RING_MASK;
+    return (b->moves[slot >> 2] >> ((slot & 3) * 2)) & 0x3;
+}
+
+static inline SnakeIter snake_iter(const SnakeBody *b, Point head, int length) {
+    SnakeIter it = {b, head, 0, length, b->head_slot};
+    return it;
+}
+
+static inline int snake_iter_valid(const SnakeIter *it) {
+    return it->index < it->length;
+}
+
+// Steps back against the move that led from this segment to the previous one
+static inline void snake_iter_next(SnakeIter *it) {
+    it->index++;
+    it->slot++;
+    int code = snake_move_code(it->body, it->slot);
+    it->pos.x -= SNAKE_DX[code];
+    it->pos.y -= SNAKE_DY[code];
+}
+
+void snake_body_init(SnakeBody *b, int length, int code);
+void snake_body_push(SnakeBody *b, int code);
+
+#endif
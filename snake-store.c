@@ -0,0 +1,139 @@
+#include "snake-store.h"
+
+#define CLAIMED 0x80  // Set on an owner cell while store_find_head_on() runs
+
+static int in_grid(Point p) {
+    return p.x >= 0 && p.x < GRID_WIDTH && p.y >= 0 && p.y < GRID_HEIGHT;
+}
+
+static void set_owner(SnakeStore *s, Point p, int value) {
+    s->owner[p.y * GRID_WIDTH + p.x] = value;
+}
+
+/**
+ * @brief Frees the cells of snake i that it still owns.
+ */
+static void release_cells(SnakeStore *s, int i) {
+    for (SnakeIter it = store_iter(s, i); snake_iter_valid(&it); snake_iter_next(&it)) {
+        if (in_grid(it.pos) && store_owner(s, it.pos) == i) {
+            set_owner(s, it.pos, 0);
+        }
+    }
+}
+
+/**
+ * @brief Removes every snake. Only their cells are freed, not the whole grid.
+ */
+void store_clear(SnakeStore *s) {
+    for (int i = 0; i < s->count; i++) {
+        release_cells(s, i);
+    }
+    s->count = 0;
+}
+
+/**
+ * @brief Adds a straight snake (see store_place) steered by kind.
+ * @return Index of the new snake, or -1 if the store is full
+ */
+int store_add(SnakeStore *s, Point head, int length, int code, int kind) {
+    if (s->count >= SNAKES_MAX) {
+        return -1;
+    }
+    int i = s->count++;
+    s->length[i] = 0;  // Nothing to release yet
+    s->kind[i] = kind;
+    s->script_length[i] = 0;
+    store_place(s, i, head, length, code);
+    return i;
+}
+
+/**
+ * @brief Replaces snake i with a straight snake whose head has just moved in
+ * direction code, the body trailing behind it. Cells must be on the grid.
+ */
+void store_place(SnakeStore *s, int i, Point head, int length, int code) {
+    release_cells(s, i);
+
+    snake_body_init(&s->body[i], length, code);
+    s->head[i] = head;
+    s->tail[i] = (Point){head.x - SNAKE_DX[code] * (length - 1), head.y - SNAKE_DY[code] * (length - 1)};
+    s->length[i] = length;
+    s->dir[i] = code;
+
+    for (SnakeIter it = store_iter(s, i); snake_iter_valid(&it); snake_iter_next(&it)) {
+        set_owner(s, it.pos, i + 1);
+    }
+}
+
+/**
+ * @brief Makes snake i a replay player following moves, looped.
+ */
+void store_set_script(SnakeStore *s, int i, const uint8_t *moves, int count) {
+    s->kind[i] = PLAYER_REPLAY;
+    s->script[i] = moves;
+    s->script_length[i] = count;
+    s->script_pos[i] = 0;
+}
+
+/**
+ * @brief Moves snake i one cell in direction code and drops its tail.
+ * The new head cell must be on the grid and free.
+ */
+void store_push(SnakeStore *s, int i, int code) {
+    SnakeBody *b = &s->body[i];
+    snake_body_push(b, code);
+    s->head[i].x += SNAKE_DX[code];
+    s->head[i].y += SNAKE_DY[code];
+    set_owner(s, s->head[i], i + 1);
+
+    // The old tail is now one past the end; the new tail is the segment it led to
+    int tail_code = snake_move_code(b, b->head_slot + s->length[i]);
+    set_owner(s, s->tail[i], 0);
+    s->tail[i].x += SNAKE_DX[tail_code];
+    s->tail[i].y += SNAKE_DY[tail_code];
+}
+
+/**
+ * @brief Grows snake i by one segment after a push, taking back the tail
+ * the push just dropped.
+ */
+void store_grow(SnakeStore *s, int i) {
+    if (s->length[i] >= SNAKE_LENGTH_MAX) {
+        return;
+    }
+    const SnakeBody *b = &s->body[i];
+    int tail_code = snake_move_code(b, b->head_slot + s->length[i]);
+    s->length[i]++;
+    s->tail[i].x -= SNAKE_DX[tail_code];
+    s->tail[i].y -= SNAKE_DY[tail_code];
+    set_owner(s, s->tail[i], i + 1);
+}
+
+/**
+ * @brief Looks for two snakes whose next heads land on the same cell.
+ * Each target cell is claimed in the owner grid and the claims are cleared
+ * again afterwards, so this is one pass over the snakes.
+ * @param next Next head position of every snake
+ * @return Index of the first snake heading for a cell already claimed, or -1
+ */
+int store_find_head_on(SnakeStore *s, const Point *next) {
+    int found = -1;
+    int claimed = 0;
+    for (; claimed < s->count; claimed++) {
+        if (!in_grid(next[claimed])) {
+            continue;  // Only one snake can reach any given off-grid cell
+        }
+        uint8_t *cell = &s->owner[next[claimed].y * GRID_WIDTH + next[claimed].x];
+        if (*cell & CLAIMED) {
+            found = claimed;
+            break;
+        }
+        *cell |= CLAIMED;
+    }
+    for (int i = 0; i < claimed; i++) {
+        if (in_grid(next[i])) {
+            s->owner[next[i].y * GRID_WIDTH + next[i].x] &= ~CLAIMED;
+        }
+    }
+    return found;
+}
@@ -0,0 +1,63 @@
+#ifndef SNAKE_STORE_H
+#define SNAKE_STORE_H
+
+#include <stdint.h>
+#include "snake-config.h"
+#include "snake-pack.h"
+
+/*
+ * Structure-of-arrays snake store.
+ * What the game step reads for every snake (head, tail, length, direction,
+ * kind) sits in small arrays next to each other; the bit-packed bodies are
+ * only touched at the head and tail. An occupancy grid records which snake
+ * covers each cell, so a collision check is one lookup per snake instead of
+ * a walk over every body, and a step costs O(snakes) however many there are.
+ */
+
+#define SNAKES_MAX 8
+
+// Who steers a snake
+#define PLAYER_HUMAN  0  // Direction switches (snakes 0 and 1 only)
+#define PLAYER_BOT    1  // Heads for the food, avoiding what it can see
+#define PLAYER_REPLAY 2  // Plays back a script of move codes
+
+typedef struct {
+    int count;
+
+    // Hot: read every step for every snake
+    Point head[SNAKES_MAX];
+    Point tail[SNAKES_MAX];
+    int length[SNAKES_MAX];      // Segments including the head
+    uint8_t dir[SNAKES_MAX];     // Move code for the next step, e.g. SNAKE_RIGHT
+    uint8_t kind[SNAKES_MAX];    // PLAYER_*
+
+    // Replay players: move codes to play back, looped
+    const uint8_t *script[SNAKES_MAX];
+    uint16_t script_length[SNAKES_MAX];
+    uint16_t script_pos[SNAKES_MAX];
+
+    // Cold: only the ring ends are touched per step
+    SnakeBody body[SNAKES_MAX];
+    uint8_t owner[GRID_CELLS];   // Snake index + 1 on each cell, 0 if free
+} SnakeStore;
+
+/*
+ * Index of the snake covering p, or -1. p must be on the grid.
+ */
+static inline int store_owner(const SnakeStore *s, Point p) {
+    return (int) (s->owner[p.y * GRID_WIDTH + p.x] & 0x7F) - 1;
+}
+
+static inline SnakeIter store_iter(const SnakeStore *s, int i) {
+    return snake_iter(&s->body[i], s->head[i], s->length[i]);
+}
+
+void store_clear(SnakeStore *s);
+int store_add(SnakeStore *s, Point head, int length, int code, int kind);
+void store_place(SnakeStore *s, int i, Point head, int length, int code);
+void store_set_script(SnakeStore *s, int i, const uint8_t *moves, int count);
+void store_push(SnakeStore *s, int i, int code);
+void store_grow(SnakeStore *s, int i);
+int store_find_head_on(SnakeStore *s, const Point *next);
+
+#endif